@@ -0,0 +1,1110 @@
+/*----------------------------------------------------------------------------
+  File    : cpubench.c
+  Contents: benchmarks for the processor information queries
+  Author  : Kristian Loewe, Christian Borgelt
+----------------------------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+#if defined __linux__ && !defined _GNU_SOURCE
+#  define _GNU_SOURCE               /* needed for sched_getcpu() */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "cpuinfo.h"
+#include "cpuhas.h"
+#include "cpudisp.h"
+#include "dotprod.h"
+
+/*----------------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------------*/
+#define REPS      1000000           /* number of repetitions per query */
+#define CPUREPS     10000           /* number of repetitions for cpuid */
+#define REFREPS      1000           /* number of repetitions of refresh */
+#define DOTLEN         64           /* vector length for dot products */
+#define MEMLEN    (1 << 22)         /* doubles per worker (memory-bound) */
+#define MEMREPS        10           /* passes over the worker's array */
+#define FLOPREPS (1 << 26)          /* iterations per worker (compute) */
+#define ENUMREPS       20           /* repetitions per enumeration */
+#define PATHMAX      4096           /* maximum length of a path */
+#define COLDREPS        5           /* processes per cold measurement */
+#define CNTREPS   (1 << 22)         /* increments per counter thread */
+#define SLOTSIZE      128           /* size of a counter slot (padded) */
+
+/*----------------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------------*/
+typedef struct {                    /* --- worker data --- */
+  const CPUSET      *set;           /* cpus to run on */
+  pthread_barrier_t *bar;           /* barrier for a common start */
+  int               mem;            /* whether to run the memory kernel */
+  double            res;            /* result of the kernel */
+} WORKER;                           /* (worker data) */
+
+typedef struct {                    /* --- counter slot --- */
+  long     cnt;                     /* counter value */
+  char     pad[SLOTSIZE -sizeof(long)];  /* (avoid false sharing) */
+} SLOT;                             /* (counter slot) */
+
+typedef struct {                    /* --- writer thread data --- */
+  volatile long     *cnt;           /* counter to increment */
+  pthread_barrier_t *bar;           /* barrier for a common start */
+} WRITER;                           /* (writer thread data) */
+
+typedef struct {                    /* --- counter thread data --- */
+  SLOT              *slots;         /* counter slots (NULL: single) */
+  int               nslots;         /* number of counter slots */
+  pthread_barrier_t *bar;           /* barrier for a common start */
+} COUNTER;                          /* (counter thread data) */
+
+/*----------------------------------------------------------------------------
+  Global Variables
+----------------------------------------------------------------------------*/
+static volatile int   sink;         /* sink for query results */
+#ifndef CPUBENCH_COLD               /* (only for the full benchmark) */
+static int32_t cache[4];            /* cpu information (cpuid) */
+static int32_t peax = -1;           /* previous eax */
+static int32_t pecx = -1;           /* previous ecx */
+static volatile float fsink;        /* sink for dot products */
+static int     mach = 0;            /* whether to print machine-readable */
+static const char *suite = "";      /* name of the current suite */
+static const char *prog  = "";      /* path of this program */
+static const char *flags =          /* flags line of a cpu entry */
+  "fpu vme de pse tsc msr pae mce cx8 apic sep mtrr pge mca cmov pat "
+  "pse36 clflush dts acpi mmx fxsr sse sse2 ss ht tm pbe syscall nx "
+  "pdpe1gb rdtscp lm constant_tsc art arch_perfmon pebs bts rep_good "
+  "nopl xtopology nonstop_tsc cpuid aperfmperf pni pclmulqdq dtes64 "
+  "monitor ds_cpl vmx smx est tm2 ssse3 sdbg fma cx16 xtpr pdcm pcid "
+  "dca sse4_1 sse4_2 x2apic movbe popcnt tsc_deadline_timer aes xsave "
+  "avx f16c rdrand lahf_lm abm 3dnowprefetch cpuid_fault epb cat_l3 "
+  "cdp_l3 invpcid_single intel_ppin ssbd mba ibrs ibpb stibp "
+  "ibrs_enhanced tpr_shadow vnmi flexpriority ept vpid ept_ad fsgsbase "
+  "tsc_adjust bmi1 hle avx2 smep bmi2 erms invpcid rtm cqm mpx rdt_a "
+  "avx512f avx512dq rdseed adx smap avx512ifma clflushopt clwb intel_pt "
+  "avx512cd sha_ni avx512bw avx512vl xsaveopt xsavec xgetbv1 xsaves "
+  "cqm_llc cqm_occup_llc cqm_mbm_total cqm_mbm_local split_lock_detect "
+  "wbnoinvd dtherm ida arat pln pts hwp hwp_act_window hwp_epp "
+  "hwp_pkg_req avx512vbmi umip pku ospke avx512_vbmi2 gfni vaes "
+  "vpclmulqdq avx512_vnni avx512_bitalg tme avx512_vpopcntdq la57 "
+  "rdpid fsrm md_clear pconfig flush_l1d arch_capabilities";
+#endif
+
+/*----------------------------------------------------------------------------
+  Functions
+----------------------------------------------------------------------------*/
+
+static double now (void)
+{                                   /* --- get current time in seconds */
+  struct timespec ts;               /* (monotonic clock) */
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec +(double)ts.tv_nsec *1e-9;
+}  /* now() */
+
+/*--------------------------------------------------------------------------*/
+
+static int q_cachesize (void)
+{ return cachesize(1); }            /* --- wrappers for the queries */
+static int q_get (void)             /* that are not int f(void) */
+{ return cpuinfo_get()->maxleaf; }
+static int q_topology (void)
+{ const CPUTOPO *t;  return cpuinfo_topology(&t); }
+static int q_caches (void)
+{ const CPUCACHE *c; return cpuinfo_caches(&c); }
+static int q_numa (void)
+{ const CPUNUMA *m;  return cpuinfo_numa(&m); }
+static int q_effective (void)
+{ const CPUEFF *e;   return cpuinfo_effective(&e); }
+static int q_timer (void)
+{ return cpuinfo_timer()->source; }
+static int q_generation (void)
+{ return (int)cpuinfo_generation(); }
+static int q_current (void)
+{ return cpuinfo_current()->cpu; }
+
+static const struct {               /* --- public queries --- */
+  const char *name;                 /* name of the query */
+  int       (*fn)(void);            /* function executing the query */
+} queries[] = {
+  { "physcnt",           physcnt           },
+  { "corecnt",           corecnt           },
+  { "proccnt",           proccnt           },
+  { "proccntmax",        proccntmax        },
+  { "nodecnt",           nodecnt           },
+  { "l3cnt",             l3cnt             },
+  { "corecntHwloc",      corecntHwloc      },
+  { "proccnt_effective", proccnt_effective },
+  { "corecnt_effective", corecnt_effective },
+  { "cachesize",         q_cachesize       },
+  { "cacheline",         cacheline         },
+  { "cpuinfo_get",       q_get             },
+  { "cpuinfo_topology",  q_topology        },
+  { "cpuinfo_caches",    q_caches          },
+  { "cpuinfo_numa",      q_numa            },
+  { "cpuinfo_effective", q_effective       },
+  { "cpuinfo_timer",     q_timer           },
+  { "cpuinfo_generation",q_generation      },
+  { "cpuinfo_current",   q_current         },
+  { "hasMMX",            hasMMX            },
+  { "hasSSE",            hasSSE            },
+  { "hasSSE2",           hasSSE2           },
+  { "hasSSE3",           hasSSE3           },
+  { "hasSSSE3",          hasSSSE3          },
+  { "hasSSE41",          hasSSE41          },
+  { "hasSSE42",          hasSSE42          },
+  { "hasPOPCNT",         hasPOPCNT         },
+  { "hasAVX",            hasAVX            },
+  { "hasAVX2",           hasAVX2           },
+  { "hasFMA3",           hasFMA3           },
+  { "hasAVX512f",        hasAVX512f        },
+  { "hasAVX512cd",       hasAVX512cd       },
+  { "hasAVX512bw",       hasAVX512bw       },
+  { "hasAVX512dq",       hasAVX512dq       },
+  { "hasAVX512vl",       hasAVX512vl       },
+  { "hasBMI1",           hasBMI1           },
+  { "hasBMI2",           hasBMI2           },
+  { "hasLZCNT",          hasLZCNT          },
+  { "hasF16C",           hasF16C           },
+  { "hasADX",            hasADX            },
+  { "hasSHA",            hasSHA            },
+  { "hasAES",            hasAES            },
+  { "hasVAES",           hasVAES           },
+  { "hasVPCLMULQDQ",     hasVPCLMULQDQ     },
+  { "hasGFNI",           hasGFNI           },
+  { "hasAVX512ifma",     hasAVX512ifma     },
+  { "hasAVX512vnni",     hasAVX512vnni     },
+  { "hasAVX512bf16",     hasAVX512bf16     },
+  { "hasAVX512fp16",     hasAVX512fp16     },
+  { "hasAVX512vbmi",     hasAVX512vbmi     },
+  { "hasAVX512vbmi2",    hasAVX512vbmi2    },
+  { "hasAVX512bitalg",   hasAVX512bitalg   },
+  { "hasAVX512vpopcntdq", hasAVX512vpopcntdq},
+  { "hasAVXvnni",        hasAVXvnni        },
+  { "hasAVX10",          hasAVX10          },
+  { "hasAMXtile",        hasAMXtile        },
+  { "hasAMXint8",        hasAMXint8        },
+  { "hasAMXbf16",        hasAMXbf16        },
+  { "hasMOVDIRI",        hasMOVDIRI        },
+  { "hasSERIALIZE",      hasSERIALIZE      },
+  { "hasFPU",            hasFPU            },
+  { "hasCX8",            hasCX8            },
+  { "hasCMOV",           hasCMOV           },
+  { "hasFXSR",           hasFXSR           },
+  { "hasSYSCALL",        hasSYSCALL        },
+  { "hasCX16",           hasCX16           },
+  { "hasLAHF",           hasLAHF           },
+  { "hasMOVBE",          hasMOVBE          },
+  { "hasOSXSAVE",        hasOSXSAVE        },
+  { "hasRDTSCP",         hasRDTSCP         },
+  { "hasRDPID",          hasRDPID          },
+};
+#define QUERYCNT  (int)(sizeof(queries)/sizeof(*queries))
+
+/*--------------------------------------------------------------------------*/
+
+#ifndef CPUBENCH_COLD
+
+static void report (const char *name, double val, const char *unit)
+{                                   /* --- report a measurement */
+  if (mach)                         /* one line per measurement, */
+    printf("%s,%s,%.6g,%s\n", suite, name, val, unit);
+  else                              /* machine-readable (CSV) or */
+    printf("%-8s %-36s %12.2f %s\n", suite, name, val, unit);
+}  /* report() */                    /* aligned for reading */
+
+/*--------------------------------------------------------------------------*/
+
+static void cpuid (int32_t info[4], int32_t eax, int32_t ecx)
+{                                   /* --- get CPU information */
+  __asm__ __volatile__ ("cpuid" :
+                        "=a" (info[0]),
+                        "=b" (info[1]),
+                        "=c" (info[2]),
+                        "=d" (info[3])
+                        : "a" (eax), "c" (ecx));
+  peax = eax;
+  pecx = ecx;
+}  /* cpuid() */
+
+/*--------------------------------------------------------------------------*/
+
+static int oldAVX (void)
+{                                   /* --- former hasAVX() (leaf 1) */
+  if ((peax != 1) || (pecx != 0)) cpuid(cache, 1, 0);
+  return (cache[2] & (1 << 28)) != 0;
+}  /* oldAVX() */
+
+/*--------------------------------------------------------------------------*/
+
+static int oldAVX2 (void)
+{                                   /* --- former hasAVX2() (leaf 7) */
+  if ((peax != 7) || (pecx != 0)) cpuid(cache, 7, 0);
+  return (cache[1] & (1 <<  5)) != 0;
+}  /* oldAVX2() */
+
+/*--------------------------------------------------------------------------*/
+
+static void bench_query (void)
+{                                   /* --- cost per has*() query */
+  int    i, s;                      /* loop variable, result sum */
+  double t, same[2], alt[2];        /* timings (before/after) */
+
+  t = now();                        /* same leaf, single-entry cache */
+  for (i = s = 0; i < REPS; i++) s += oldAVX();
+  same[0] = (now() -t) *1e9 /REPS;
+  t = now();                        /* alternating leaves, old scheme */
+  for (i = 0; i < CPUREPS; i++) s += (i & 1) ? oldAVX2() : oldAVX();
+  alt[0]  = (now() -t) *1e9 /CPUREPS;
+  t = now();                        /* same leaf, snapshot */
+  for (i = 0; i < REPS; i++) s += hasAVX();
+  same[1] = (now() -t) *1e9 /REPS;
+  t = now();                        /* alternating leaves, snapshot */
+  for (i = 0; i < REPS; i++) s += (i & 1) ? hasAVX2() : hasAVX();
+  alt[1]  = (now() -t) *1e9 /REPS;
+  sink = s;
+  report("hasAVX()/before",           same[0], "ns");
+  report("hasAVX()/after",            same[1], "ns");
+  report("hasAVX()+hasAVX2()/before", alt[0],  "ns");
+  report("hasAVX()+hasAVX2()/after",  alt[1],  "ns");
+}  /* bench_query() */
+
+/*--------------------------------------------------------------------------*/
+
+static double coldtime (const char *name)
+{                                   /* --- cold cost of a query */
+  char   cmd[PATHMAX];              /* command to execute */
+  FILE   *fp;                       /* pipe from the child process */
+  int    i, k;                      /* loop variable, length of dir. */
+  double t, min = -1;               /* time of a cold call, minimum */
+
+  k = (int)(strrchr(prog, '/') ? strrchr(prog, '/') -prog +1 : 0);
+  snprintf(cmd, sizeof(cmd), "%.*scpucold %s", k, prog, name);
+  for (i = 0; i < COLDREPS; i++) {  /* run the query in fresh processes */
+    fp = popen(cmd, "r");
+    if (!fp) return -1;
+    if ((fscanf(fp, "%lf", &t) == 1) && ((min < 0) || (t < min)))
+      min = t;                      /* read the time of the call */
+    pclose(fp);                     /* and keep the minimum */
+  }
+  return min;                       /* return the minimum time */
+}  /* coldtime() */
+
+/*--------------------------------------------------------------------------*/
+
+static void bench_api (void)
+{                                   /* --- cold and warm cost of queries */
+  int    i, k, s = 0;               /* loop variables, result sum */
+  double t;                         /* time of the warm calls */
+  char   name[64];                  /* name of a measurement */
+
+  for (i = 0; i < QUERYCNT; i++) {  /* traverse the queries */
+    sprintf(name, "%s/cold", queries[i].name);
+    report(name, coldtime(queries[i].name), "ns");
+    s += queries[i].fn();           /* initialize the query */
+    t = now();                      /* and time repeated calls */
+    for (k = 0; k < REPS; k++) s += queries[i].fn();
+    sprintf(name, "%s/warm", queries[i].name);
+    report(name, (now() -t) *1e9 /REPS, "ns");
+  }
+  s += cpuinfo_refresh();           /* time the refresh separately, */
+  t = now();                        /* as it reads some files */
+  for (k = 0; k < REFREPS; k++) s += cpuinfo_refresh();
+  report("cpuinfo_refresh/warm", (now() -t) *1e9 /REFREPS, "ns");
+  sink = s;
+}  /* bench_api() */
+
+/*--------------------------------------------------------------------------*/
+
+static void bench_cpuid (void)
+{                                   /* --- raw latency of cpuid */
+  static const int32_t leaves[] = { 0, 1, 7, 0x0b, (int32_t)0x80000000 };
+  int32_t info[4];                  /* result of a cpuid call */
+  int     i, k, s = 0;              /* loop variables, result sum */
+  double  t;                        /* time of the calls */
+  char    name[64];                 /* name of a measurement */
+
+  for (i = 0; i < (int)(sizeof(leaves)/sizeof(*leaves)); i++) {
+    t = now();                      /* traverse the leaves */
+    for (k = 0; k < CPUREPS; k++) { cpuid(info, leaves[i], 0); s += info[0]; }
+    sprintf(name, "leaf 0x%x", (unsigned)leaves[i]);
+    report(name, (now() -t) *1e9 /CPUREPS, "ns");
+  }
+  sink = s;
+}  /* bench_cpuid() */
+
+/*--------------------------------------------------------------------------*/
+
+static float dot_chain (const float *a, const float *b, int n)
+{                                   /* --- feature check at call site */
+  if (hasAVX512f())             return dot_avx512(a, b, n);
+  if (hasAVX2() && hasFMA3())   return dot_avx2  (a, b, n);
+  if (hasSSE2())                return dot_sse2  (a, b, n);
+  return dot_naive(a, b, n);
+}  /* dot_chain() */
+
+/*--------------------------------------------------------------------------*/
+
+static float dot_fold (const float *a, const float *b, int n)
+{                                   /* --- checks folded at compile time */
+  if (CPU_HAS(AVX512F))               return dot_avx512(a, b, n);
+  if (CPU_HAS(AVX2) && CPU_HAS(FMA3)) return dot_avx2  (a, b, n);
+  if (CPU_HAS(SSE2))                  return dot_sse2  (a, b, n);
+  return dot_naive(a, b, n);        /* with -march=native only the */
+}  /* dot_fold() */                 /* best branch remains */
+
+/*--------------------------------------------------------------------------*/
+
+static void bench_disp (void)
+{                                   /* --- dispatched vs. direct calls */
+  static float a[DOTLEN], b[DOTLEN];/* vectors to multiply */
+  int    i;                         /* loop variable */
+  float  s = 0;                     /* sum of dot products */
+  double t, d[5];                   /* timings */
+  DOTFN  *best;                     /* best implementation */
+
+  for (i = 0; i < DOTLEN; i++) {    /* initialize the vectors */
+    a[i] = (float)i; b[i] = 1.0f/(float)(i+1); }
+  best = dot_naive;                 /* find the implementation */
+  if (hasSSE2())                best = dot_sse2;    /* that the */
+  if (hasAVX2() && hasFMA3())   best = dot_avx2;    /* dispatcher */
+  if (hasAVX512f())             best = dot_avx512;  /* will select */
+  s += dot(a, b, DOTLEN);           /* resolve the dispatch table */
+  t = now();
+  if      (best == dot_avx512) for (i = 0; i < REPS; i++)
+    s += dot_avx512(a, b, DOTLEN);
+  else if (best == dot_avx2)   for (i = 0; i < REPS; i++)
+    s += dot_avx2  (a, b, DOTLEN);
+  else if (best == dot_sse2)   for (i = 0; i < REPS; i++)
+    s += dot_sse2  (a, b, DOTLEN);
+  else                         for (i = 0; i < REPS; i++)
+    s += dot_naive (a, b, DOTLEN);
+  d[0] = (now() -t) *1e9 /REPS;     /* direct call */
+  t = now();
+  for (i = 0; i < REPS; i++) s += dot(a, b, DOTLEN);
+  d[1] = (now() -t) *1e9 /REPS;     /* function pointer table */
+  t = now();
+  for (i = 0; i < REPS; i++) s += dot_ifunc(a, b, DOTLEN);
+  d[2] = (now() -t) *1e9 /REPS;     /* GNU ifunc (if available) */
+  t = now();
+  for (i = 0; i < REPS; i++) s += dot_chain(a, b, DOTLEN);
+  d[3] = (now() -t) *1e9 /REPS;     /* feature checks at call site */
+  t = now();
+  for (i = 0; i < REPS; i++) s += dot_fold(a, b, DOTLEN);
+  d[4] = (now() -t) *1e9 /REPS;     /* checks folded by the compiler */
+  fsink = s;
+  report("dot/direct",          d[0], "ns");
+  report("dot/pointer",         d[1], "ns");
+  report(CPUDISP_HAVE_IFUNC ? "dot/ifunc" : "dot/ifunc-fallback",
+                                d[2], "ns");
+  report("dot/if-chain",        d[3], "ns");
+  report("dot/folded",          d[4], "ns");
+}  /* bench_disp() */
+
+/*--------------------------------------------------------------------------*/
+
+static void* work (void *arg)
+{                                   /* --- worker thread */
+  WORKER *w = (WORKER*)arg;         /* worker data */
+  double *a = NULL, x, y;           /* array for memory-bound kernel */
+  long   i, k;                      /* loop variables */
+
+  cpuinfo_pin(w->set);              /* pin the thread */
+  if (w->mem) {                     /* allocate and touch the array */
+    a = malloc(MEMLEN *sizeof(double));  /* after pinning, so that */
+    if (a) for (i = 0; i < MEMLEN; i++) a[i] = 1; /* it is local */
+  }
+  pthread_barrier_wait(w->bar);     /* wait for the other workers */
+  x = 0; y = 1.000001;              /* run the kernel */
+  if (w->mem && a) {                /* memory-bound: sum the array */
+    for (k = 0; k < MEMREPS; k++)
+      for (i = 0; i < MEMLEN; i++) x += a[i];
+  }
+  else if (!w->mem) {               /* compute-bound: dependent */
+    for (i = 0; i < FLOPREPS; i++)  /* multiply-adds */
+      x = x *y +1e-9;
+  }
+  free(a);                          /* delete the array */
+  w->res = x;                       /* store the result */
+  return NULL;                      /* (to prevent optimizing it away) */
+}  /* work() */
+
+/*--------------------------------------------------------------------------*/
+
+static double run (const CPUSET *sets, int n, int mem)
+{                                   /* --- run workers with a placement */
+  pthread_t         *th;            /* worker threads */
+  WORKER            *w;             /* worker data */
+  pthread_barrier_t bar;            /* barrier for a common start */
+  int               i;              /* loop variable */
+  double            t;              /* wall clock time */
+
+  th = malloc((size_t)n *sizeof(pthread_t));
+  w  = malloc((size_t)n *sizeof(WORKER));
+  if (!th || !w) { free(th); free(w); return -1; }
+  pthread_barrier_init(&bar, NULL, (unsigned)n+1);
+  for (i = 0; i < n; i++) {         /* start the workers */
+    w[i].set = sets +i; w[i].bar = &bar; w[i].mem = mem;
+    pthread_create(th +i, NULL, work, w +i);
+  }
+  pthread_barrier_wait(&bar);       /* wait until all are ready */
+  t = now();                        /* and start the clock */
+  for (i = 0; i < n; i++) pthread_join(th[i], NULL);
+  t = now() -t;                     /* wait for the workers */
+  pthread_barrier_destroy(&bar);
+  free(th); free(w);                /* delete the worker data */
+  return t;                         /* return the wall clock time */
+}  /* run() */
+
+/*--------------------------------------------------------------------------*/
+
+static void bench_place (void)
+{                                   /* --- compare placement policies */
+  static const char *names[] = {    /* names of the policies */
+    "compact", "scatter", "nosmt", "l3", "numa" };
+  CPUSET *sets;                     /* cpu sets of the workers */
+  int    n, p, k;                   /* # workers, policy, # places */
+  double tm, tc;                    /* times of the kernels */
+  char   name[64];                  /* name of a measurement */
+
+  n = corecnt_effective();          /* use one worker per core */
+  if (n <= 0) n = 1;
+  sets = malloc((size_t)n *sizeof(CPUSET));
+  if (!sets) return;
+  report("workers", n, "");
+  for (p = CPU_PLACE_COMPACT; p <= CPU_PLACE_NUMA; p++) {
+    k = cpuinfo_place(n, p, sets);  /* place the workers */
+    if (k <= 0) continue;
+    tm = run(sets, n, 1);           /* run the memory-bound */
+    tc = run(sets, n, 0);           /* and the compute-bound kernel */
+    sprintf(name, "%s/places",  names[p]); report(name, k, "");
+    sprintf(name, "%s/memory",  names[p]);
+    report(name, (double)n *MEMREPS *MEMLEN *sizeof(double) /tm *1e-9,
+           "GB/s");
+    sprintf(name, "%s/compute", names[p]); report(name, tc, "s");
+  }
+  free(sets);                       /* delete the cpu sets */
+}  /* bench_place() */
+
+/*--------------------------------------------------------------------------*/
+
+static int oldenum (const char *path)
+{                                   /* --- former /proc/cpuinfo parser */
+  FILE *fp;                         /* file for /proc/cpuinfo */
+  int  i, c, p, n;                  /* loop variables, # processors */
+
+  fp = fopen(path, "r");            /* (fscanf on every line) */
+  if (!fp) return -1;
+  for (c = p = n = 0; c != EOF; ) {
+    if      (fscanf(fp, "physical id : %d", &i) > 0) {
+      sink = i; p |= 1; }
+    else if (fscanf(fp, "core id : %d",     &i) > 0) {
+      sink = i; p |= 2; }
+    if (p >= 3) { p = 0; n += 1; }
+    while (((c = fgetc(fp)) != EOF) && (c != '\n'));
+  }
+  fclose(fp);
+  return n;                         /* return the number of processors */
+}  /* oldenum() */
+
+/*--------------------------------------------------------------------------*/
+
+static int putfile (const char *root, const char *name, const char *text)
+{                                   /* --- write a fixture file */
+  char buf[PATHMAX], *s;            /* buffer for the path */
+  FILE *fp;                         /* file to write */
+  int  n;                           /* length of the path */
+
+  n = snprintf(buf, sizeof(buf), "%s%s", root, name);
+  if ((n < 0) || (n >= (int)sizeof(buf))) return -1;
+  for (s = buf +1; (s = strchr(s, '/')) != NULL; s++) {
+    *s = 0; mkdir(buf, 0755); *s = '/'; }
+  fp = fopen(buf, "w");             /* create the directories */
+  if (!fp) return -1;               /* and write the file */
+  fputs(text, fp);
+  return fclose(fp);
+}  /* putfile() */
+
+/*--------------------------------------------------------------------------*/
+
+static void putmask (const char *root, const char *name, int n,
+                     int lo, int hi, int step)
+{                                   /* --- write a cpu mask file */
+  uint32_t w[CPUSET_MAX/32];        /* mask words (32 cpus each) */
+  char     text[CPUSET_MAX/4 +CPUSET_MAX/32 +2];
+  int      i, k;                    /* loop variable, text length */
+
+  memset(w, 0, sizeof(w));          /* set the bits of the cpus */
+  for (i = lo; i <= hi; i += step) w[i >> 5] |= (uint32_t)1 << (i & 31);
+  for (k = 0, i = (n-1) >> 5; i >= 0; i--)
+    k += sprintf(text +k, "%08x%s", w[i], (i > 0) ? "," : "\n");
+  putfile(root, name, text);        /* write the words in the format */
+}  /* putmask() */                  /* of the kernel (highest first) */
+
+/*--------------------------------------------------------------------------*/
+
+static int fixture (const char *root, int n, int sysfs)
+{                                   /* --- create a fake root */
+  char   name[256], text[64];       /* file name and contents */
+  char   *buf;                      /* buffer for /proc/cpuinfo */
+  size_t len, k;                    /* length of /proc/cpuinfo */
+  int    i, pkg, core;              /* loop variable, ids */
+  int    npkg = (n >= 16) ? 2 : 1;  /* number of packages */
+  int    ncpp = n /npkg /2;         /* cores per package (2-way SMT) */
+
+  len = (size_t)n *(strlen(flags) +1024);
+  buf = malloc(len);                /* create buffer for /proc/cpuinfo */
+  if (!buf) return -1;
+  for (i = 0, k = 0; i < n; i++) {  /* traverse the cpus */
+    pkg  = i /(n /npkg);            /* (cpus of the second SMT thread */
+    core = i %ncpp;                 /* follow all first threads) */
+    k += (size_t)snprintf(buf +k, len -k,
+      "processor\t: %d\nvendor_id\t: GenuineIntel\ncpu family\t: 6\n"
+      "model\t\t: 106\nmodel name\t: Intel(R) Xeon(R) Gold 6338 CPU"
+      " @ 2.00GHz\nstepping\t: 6\nmicrocode\t: 0xd0003a5\n"
+      "cpu MHz\t\t: 2000.000\ncache size\t: 49152 KB\n"
+      "physical id\t: %d\nsiblings\t: %d\ncore id\t\t: %d\n"
+      "cpu cores\t: %d\napicid\t\t: %d\ninitial apicid\t: %d\n"
+      "fpu\t\t: yes\nfpu_exception\t: yes\ncpuid level\t: 27\n"
+      "wp\t\t: yes\nflags\t\t: %s\nbogomips\t: 4000.00\n"
+      "clflush size\t: 64\ncache_alignment\t: 64\n"
+      "address sizes\t: 46 bits physical, 57 bits virtual\n"
+      "power management:\n\n", i, pkg, n /npkg, core, ncpp,
+      i, i, flags);
+    if (!sysfs) continue;           /* write the sysfs topology */
+    sprintf(name, "/sys/devices/system/cpu/cpu%d/topology/", i);
+    sprintf(text, "%d-%d\n", pkg *(n /npkg), (pkg+1) *(n /npkg) -1);
+    strcat(name, "core_siblings_list"); putfile(root, name, text);
+    sprintf(text, "%d,%d\n", pkg *(n /npkg) +core,
+                             pkg *(n /npkg) +core +ncpp);
+    sprintf(strrchr(name, '/')+1, "thread_siblings_list");
+    putfile(root, name, text);      /* (hwloc needs the masks) */
+    sprintf(strrchr(name, '/')+1, "core_siblings");
+    putmask(root, name, n, pkg *(n /npkg), (pkg+1) *(n /npkg) -1, 1);
+    sprintf(strrchr(name, '/')+1, "thread_siblings");
+    putmask(root, name, n, pkg *(n /npkg) +core,
+                           pkg *(n /npkg) +core +ncpp, ncpp);
+  }
+  putfile(root, "/proc/cpuinfo", buf);
+  free(buf);                        /* write /proc/cpuinfo */
+  if (!sysfs) return 0;             /* and the online cpus */
+  sprintf(text, "0-%d\n", n-1);
+  return putfile(root, "/sys/devices/system/cpu/online", text);
+}  /* fixture() */
+
+/*--------------------------------------------------------------------------*/
+
+static void rmtree (const char *path)
+{                                   /* --- remove a directory tree */
+  char          buf[PATHMAX];       /* buffer for the entry paths */
+  DIR           *dir;               /* directory to traverse */
+  struct dirent *e;                 /* directory entry */
+
+  dir = opendir(path);              /* traverse the directory */
+  if (!dir) { remove(path); return; }
+  while ((e = readdir(dir)) != NULL) {
+    if ((strcmp(e->d_name, ".")  == 0)
+    ||  (strcmp(e->d_name, "..") == 0)) continue;
+    snprintf(buf, sizeof(buf), "%s/%s", path, e->d_name);
+    rmtree(buf);                    /* remove the entries */
+  }
+  closedir(dir);
+  rmdir(path);                      /* remove the directory itself */
+}  /* rmtree() */
+
+/*--------------------------------------------------------------------------*/
+
+static double enumtime (const char *root)
+{                                   /* --- time the count enumeration */
+  int    i, s = 0;                  /* loop variable, result sum */
+  double t;                         /* time of the enumeration */
+
+  t = now();                        /* set the root (which discards */
+  for (i = 0; i < ENUMREPS; i++) {  /* the counts) and enumerate */
+    cpuinfo_setroot(root); s += corecnt(); }
+  t = (now() -t) *1e6 /ENUMREPS;
+  sink = s;
+  return t;                         /* return time per enumeration */
+}  /* enumtime() */
+
+/*--------------------------------------------------------------------------*/
+
+static void bench_enum (void)
+{                                   /* --- enumeration of the topology */
+  static const int sizes[] = { 4, 16, 64, 256, 1024 };
+  char   dir[] = "/tmp/cpubenchXXXXXX";
+  char   sys[PATHMAX], proc[PATHMAX];
+  char   name[64];                  /* name of a measurement */
+  int    i, k, s = 0;               /* loop variables, result sum */
+  double t, d[3];                   /* timings */
+
+  if (!mkdtemp(dir)) return;        /* create a temporary directory */
+  for (i = 0; i < (int)(sizeof(sizes)/sizeof(*sizes)); i++) {
+    snprintf(sys,  sizeof(sys),  "%s/sys%d",  dir, sizes[i]);
+    snprintf(proc, sizeof(proc), "%s/proc%d", dir, sizes[i]);
+    if ((fixture(sys, sizes[i], 1)  != 0)
+    ||  (fixture(proc, sizes[i], 0) != 0)) break;
+    strcat(proc, "/proc/cpuinfo");  /* time the former parser */
+    t = now();
+    for (k = 0; k < ENUMREPS; k++) s += oldenum(proc);
+    d[0] = (now() -t) *1e6 /ENUMREPS;
+    *strrchr(proc, '/') = 0;        /* time bulk read of /proc/cpuinfo */
+    *strrchr(proc, '/') = 0;        /* and the sysfs topology files */
+    d[1] = enumtime(proc);
+    d[2] = enumtime(sys);
+    sprintf(name, "%d/fscanf", sizes[i]); report(name, d[0], "us");
+    sprintf(name, "%d/proc",   sizes[i]); report(name, d[1], "us");
+    sprintf(name, "%d/sysfs",  sizes[i]); report(name, d[2], "us");
+  }
+  sink = s;
+  cpuinfo_setroot(NULL);            /* restore the real root */
+  rmtree(dir);                      /* and remove the fixtures */
+}  /* bench_enum() */
+
+/*--------------------------------------------------------------------------*/
+
+static void bench_timer (void)
+{                                   /* --- cost of reading a timer */
+  const CPUTIMER *tm;               /* tick timer */
+  int      i;                       /* loop variable */
+  uint64_t s = 0;                   /* sum of readings */
+  double   t, d[2];                 /* timings */
+
+  tm = cpuinfo_timer();             /* initialize the timer */
+  t = now();
+  for (i = 0; i < REPS; i++) s += (uint64_t)now();
+  d[0] = (now() -t) *1e9 /REPS;     /* clock_gettime() */
+  t = now();
+  for (i = 0; i < REPS; i++) s += cpuinfo_ticks();
+  d[1] = (now() -t) *1e9 /REPS;     /* cpuinfo_ticks() */
+  sink = (int)s;
+  report("clock_gettime()",           d[0], "ns");
+  report("cpuinfo_ticks()",           d[1], "ns");
+  report("cpuinfo_ticks()/source",    tm->source, "");
+  report("cpuinfo_ticks()/read",      tm->read, "");
+  report("cpuinfo_ticks()/frequency", tm->hz *1e-6, "MHz");
+  report("cpuinfo_ticks()/overhead",  tm->overhead, "ns");
+  report("cpuinfo_ticks()/resolution",tm->resolution, "ns");
+}  /* bench_timer() */
+
+/*--------------------------------------------------------------------------*/
+
+static void backends (const char *root, const char *prefix,
+                      const int *cnts)
+{                                   /* --- time and compare backends */
+  char   name[64];                  /* name of a measurement */
+  int    b, i, s = 0;               /* backend, loop variable, sum */
+  double t;                         /* time of the enumeration */
+
+  for (b = CPU_BACKEND_SYSFS; b < CPU_BACKEND_CNT; b++) {
+    if (cpuinfo_setbackend(b) != 0) continue;
+    t = now();                      /* time the cold enumeration */
+    for (i = 0; i < ENUMREPS; i++) {/* (setting the root discards */
+      cpuinfo_setroot(root); s += corecnt(); }  /* all loaded data) */
+    t = (now() -t) *1e6 /ENUMREPS;
+    if (cpuinfo_backend() != b) continue;   /* skip failed backends */
+    sprintf(name, "%s/%s", prefix, cpuinfo_backendname(b));
+    report(name, t, "us");          /* report the time and whether */
+    strcat(name, "/agree");         /* the counts agree */
+    report(name, (physcnt() == cnts[0]) && (corecnt() == cnts[1])
+              && (proccnt() == cnts[2]), "");
+  }
+  sink = s;
+  cpuinfo_setbackend(CPU_BACKEND_AUTO);
+}  /* backends() */
+
+/*--------------------------------------------------------------------------*/
+
+static void bench_backend (void)
+{                                   /* --- topology backends */
+  static const int sizes[] = { 4, 64, 1024 };
+  char   dir[] = "/tmp/cpubenchXXXXXX";
+  char   sys[PATHMAX];              /* root of a fixture */
+  char   name[64];                  /* name prefix of measurements */
+  int    i, cnts[3];                /* loop variable, expected counts */
+
+  cpuinfo_setroot(NULL);            /* compare with the sysfs counts */
+  cpuinfo_setbackend(CPU_BACKEND_SYSFS);    /* on the real machine */
+  cnts[0] = physcnt(); cnts[1] = corecnt(); cnts[2] = proccnt();
+  backends(NULL, "host", cnts);
+  if (!mkdtemp(dir)) return;        /* create a temporary directory */
+  for (i = 0; i < (int)(sizeof(sizes)/sizeof(*sizes)); i++) {
+    snprintf(sys, sizeof(sys), "%s/sys%d", dir, sizes[i]);
+    if (fixture(sys, sizes[i], 1) != 0) break;
+    cnts[0] = (sizes[i] >= 16) ? 2 : 1;
+    cnts[1] = sizes[i] /2;          /* (2-way SMT on all cores) */
+    cnts[2] = sizes[i];             /* hwloc reads a fake root */
+    setenv("HWLOC_FSROOT", sys, 1); /* given by HWLOC_FSROOT */
+    sprintf(name, "%d", sizes[i]);
+    backends(sys, name, cnts);
+  }
+  unsetenv("HWLOC_FSROOT");         /* restore the real root */
+  cpuinfo_setroot(NULL);            /* and remove the fixtures */
+  rmtree(dir);
+}  /* bench_backend() */
+
+/*--------------------------------------------------------------------------*/
+
+static double loadtime (const char *root, const char *file)
+{                                   /* --- time loading all data */
+  const CPUTOPO  *t;                /* processor topology */
+  const CPUCACHE *c;                /* cache descriptions */
+  const CPUNUMA  *m;                /* NUMA node topology */
+  const CPUEFF   *e;                /* effective cpu resources */
+  int            i, s = 0;          /* loop variable, result sum */
+  double         d;                 /* time of the loading */
+
+  cpuinfo_import(NULL);             /* set the root of the files */
+  cpuinfo_setroot(root);            /* (without imported data) */
+  d = now();                        /* and time the loading */
+  for (i = 0; i < ENUMREPS; i++) {  /* (importing or setting the root */
+    if (file) cpuinfo_import(file); /* discards all loaded data) */
+    else      cpuinfo_setroot(root);
+    s += corecnt() +cpuinfo_topology(&t) +cpuinfo_caches(&c)
+       + cpuinfo_numa(&m) +cpuinfo_effective(&e);
+  }
+  sink = s;
+  return (now() -d) *1e6 /ENUMREPS; /* return time per loading */
+}  /* loadtime() */
+
+/*--------------------------------------------------------------------------*/
+
+static void bench_file (void)
+{                                   /* --- import of a description */
+  char   dir[] = "/tmp/cpubenchXXXXXX";
+  char   sys[PATHMAX], file[PATHMAX];
+  double d[2];                      /* timings */
+
+  if (!mkdtemp(dir)) return;        /* create a temporary directory */
+  snprintf(file, sizeof(file), "%s/host.bin", dir);
+  cpuinfo_setroot(NULL);            /* time loading the description */
+  if (cpuinfo_export(file) == 0) {  /* of the real machine */
+    d[0] = loadtime(NULL, NULL);    /* from cpuid/sysfs/procfs */
+    d[1] = loadtime(NULL, file);    /* and from the exported file */
+    report("host/probe",  d[0], "us");
+    report("host/import", d[1], "us");
+  }
+  snprintf(sys,  sizeof(sys),  "%s/sys1024",  dir);
+  snprintf(file, sizeof(file), "%s/1024.bin", dir);
+  cpuinfo_import(NULL);             /* the same for a fixture */
+  cpuinfo_setroot(sys);
+  if ((fixture(sys, 1024, 1) == 0) && (cpuinfo_export(file) == 0)) {
+    d[0] = loadtime(sys, NULL);
+    d[1] = loadtime(sys, file);
+    report("1024/probe",  d[0], "us");
+    report("1024/import", d[1], "us");
+  }
+  cpuinfo_import(NULL);             /* restore the real machine */
+  cpuinfo_setroot(NULL);            /* and remove the fixtures */
+  rmtree(dir);
+}  /* bench_file() */
+
+/*--------------------------------------------------------------------------*/
+
+static void* count (void *arg)
+{                                   /* --- counter thread */
+  COUNTER *c = (COUNTER*)arg;       /* counter thread data */
+  SLOT    *s;                       /* slot to increment */
+  int     i, k;                     /* loop variable, slot index */
+
+  pthread_barrier_wait(c->bar);     /* wait for the other threads */
+  for (i = 0; i < CNTREPS; i++) {   /* increment the counter */
+    k = (c->nslots > 1) ? cpuinfo_current()->cpu : 0;
+    s = c->slots +(((unsigned)k < (unsigned)c->nslots) ? k : 0);
+    __atomic_fetch_add(&s->cnt, 1, __ATOMIC_RELAXED);
+  }                                 /* (relaxed, as the thread may */
+  return NULL;                      /* migrate between the two steps) */
+}  /* count() */
+
+/*--------------------------------------------------------------------------*/
+
+static double counter (int n, SLOT *slots, int nslots)
+{                                   /* --- run counter threads */
+  pthread_t         *th;            /* counter threads */
+  COUNTER           c;              /* counter thread data */
+  pthread_barrier_t bar;            /* barrier for a common start */
+  int               i;              /* loop variable */
+  double            t;              /* wall clock time */
+
+  th = malloc((size_t)n *sizeof(pthread_t));
+  if (!th) return -1;               /* allocate the thread handles */
+  c.slots = slots; c.nslots = nslots; c.bar = &bar;
+  pthread_barrier_init(&bar, NULL, (unsigned)n+1);
+  for (i = 0; i < n; i++)           /* start the threads */
+    pthread_create(th +i, NULL, count, &c);
+  pthread_barrier_wait(&bar);       /* wait until all are ready */
+  t = now();                        /* and start the clock */
+  for (i = 0; i < n; i++) pthread_join(th[i], NULL);
+  t = now() -t;                     /* wait for the threads */
+  pthread_barrier_destroy(&bar);
+  free(th);                         /* delete the thread handles */
+  return t *1e9 /((double)n *CNTREPS);
+}  /* counter() */                  /* return the time per increment */
+
+/*--------------------------------------------------------------------------*/
+
+static void bench_current (void)
+{                                   /* --- current cpu, sharded counter */
+  static const char *methods[] = { "none", "rdpid", "rdtscp", "getcpu" };
+  SLOT   *slots;                    /* counter slots */
+  int    i, n, k, s = 0;            /* loop variable, numbers, sum */
+  double t, d[2];                   /* timings */
+  char   name[64];                  /* name of a measurement */
+
+  s += cpuinfo_current()->cpu;      /* build the table */
+  t = now();                        /* and time repeated calls */
+  for (i = 0; i < REPS; i++) s += cpuinfo_current()->node;
+  sprintf(name, "cpuinfo_current()/%s", methods[cpuinfo_curmethod()]);
+  report(name, (now() -t) *1e9 /REPS, "ns");
+  #ifdef __linux__                  /* compare with the OS, which */
+  t = now();                        /* yields only the cpu number */
+  for (i = 0; i < REPS; i++) s += sched_getcpu();
+  report("sched_getcpu()", (now() -t) *1e9 /REPS, "ns");
+  #endif
+  sink = s;
+  n = proccnt_effective();          /* use one thread per cpu */
+  if (n < 2) n = 2;                 /* (at least two for contention) */
+  k = CPUSET_MAX;                   /* one slot per possible cpu */
+  slots = calloc((size_t)k, sizeof(SLOT));
+  if (!slots) return;
+  d[0] = counter(n, slots, 1);      /* single shared counter */
+  d[1] = counter(n, slots, k);      /* counter sharded per cpu */
+  report("threads",         n,    "");
+  report("counter/single",  d[0], "ns");
+  report("counter/sharded", d[1], "ns");
+  free(slots);                      /* delete the counter slots */
+}  /* bench_current() */
+
+/*--------------------------------------------------------------------------*/
+
+static void* writer (void *arg)
+{                                   /* --- writer thread */
+  WRITER *w = (WRITER*)arg;         /* writer thread data */
+  int    i;                         /* loop variable */
+
+  pthread_barrier_wait(w->bar);     /* wait for the other threads */
+  for (i = 0; i < CNTREPS; i++)     /* increment the own counter */
+    (*w->cnt)++;                    /* (not shared with other threads) */
+  return NULL;
+}  /* writer() */
+
+/*--------------------------------------------------------------------------*/
+
+static double writers (int n, char *base, size_t stride)
+{                                   /* --- run writer threads */
+  pthread_t         *th;            /* writer threads */
+  WRITER            *w;             /* writer thread data */
+  pthread_barrier_t bar;            /* barrier for a common start */
+  int               i;              /* loop variable */
+  double            t;              /* wall clock time */
+
+  th = malloc((size_t)n *sizeof(pthread_t));
+  w  = malloc((size_t)n *sizeof(WRITER));
+  if (!th || !w) { free(th); free(w); return -1; }
+  pthread_barrier_init(&bar, NULL, (unsigned)n+1);
+  for (i = 0; i < n; i++) {         /* start the threads */
+    w[i].cnt = (volatile long*)(base +(size_t)i *stride);
+    w[i].bar = &bar; *w[i].cnt = 0;
+    pthread_create(th +i, NULL, writer, w +i);
+  }
+  pthread_barrier_wait(&bar);       /* wait until all are ready */
+  t = now();                        /* and start the clock */
+  for (i = 0; i < n; i++) pthread_join(th[i], NULL);
+  t = now() -t;                     /* wait for the threads */
+  pthread_barrier_destroy(&bar);
+  free(th); free(w);                /* delete the thread data */
+  return t *1e9 /CNTREPS;           /* return the time per increment */
+}  /* writers() */
+
+/*--------------------------------------------------------------------------*/
+
+static double readtime (const double *a, const CPUSET *set)
+{                                   /* --- time reading an array */
+  long   i, k;                      /* loop variables */
+  double x = 0, t;                  /* sum of the elements, time */
+
+  cpuinfo_pin(set);                 /* run on the given cpus */
+  for (i = 0; i < MEMLEN; i++) x += a[i];
+  t = now();                        /* read the array once (warm-up) */
+  for (k = 0; k < MEMREPS; k++)     /* and then time the reading */
+    for (i = 0; i < MEMLEN; i++) x += a[i];
+  t = now() -t;
+  fsink = (float)x;
+  return (double)MEMREPS *MEMLEN *sizeof(double) /t *1e-9;
+}  /* readtime() */                 /* return the bandwidth in GB/s */
+
+/*--------------------------------------------------------------------------*/
+
+static void bench_alloc (void)
+{                                   /* --- padding and node placement */
+  const CPUNUMA  *m;                /* NUMA node topology */
+  const CPUEFF   *e;                /* effective cpu resources */
+  CPUSET         set;               /* cpus of node 0 */
+  char           *base;             /* counters of the writers */
+  double         *a;                /* array to read */
+  int            i, n, pad, far;    /* loop variable, # threads etc. */
+  size_t         size;              /* size of the array */
+  char           name[64];          /* name of a measurement */
+
+  pad = cpuinfo_padsize();          /* get the padding size */
+  report("padsize", pad, "bytes");
+  n = proccnt_effective();          /* use one thread per cpu */
+  if (n < 2) n = 2;                 /* (at least two for contention) */
+  base = cpuinfo_alloc((size_t)n *(size_t)pad, 0);
+  if (!base) return;                /* allocate the counters */
+  report("writers/packed", writers(n, base, sizeof(long)), "ns");
+  report("writers/64",     writers(n, base, 64),           "ns");
+  sprintf(name, "writers/%d", pad);
+  report(name,             writers(n, base, (size_t)pad),  "ns");
+  cpuinfo_free(base);               /* delete the counters */
+  if ((cpuinfo_numa(&m) != 0) || (m->nodeoff[1] <= m->nodeoff[0])
+  ||  (cpuinfo_effective(&e) != 0))
+    return;                         /* get the NUMA topology */
+  memset(&set, 0, sizeof(set));     /* collect the cpus of node 0 */
+  for (i = m->nodeoff[0]; i < m->nodeoff[1]; i++)
+    if (m->nodecpus[i] < CPUSET_MAX) CPUSET_SET(&set, m->nodecpus[i]);
+  for (far = i = 0; i < m->nnodes; i++)   /* find the farthest node */
+    if (m->dist[i] > m->dist[far]) far = i;
+  size = MEMLEN *sizeof(double);    /* compare node-local and remote */
+  a = cpuinfo_nodealloc(size, 0);   /* memory (if there is more */
+  if (a) {                          /* than one node) */
+    report("node/local", readtime(a, &set), "GB/s");
+    cpuinfo_nodefree(a, size); }
+  a = (far > 0) ? cpuinfo_nodealloc(size, far) : NULL;
+  if (a) {
+    report("node/remote", readtime(a, &set), "GB/s");
+    cpuinfo_nodefree(a, size); }
+  cpuinfo_pin(&e->allowed);         /* restore the affinity */
+}  /* bench_alloc() */
+
+/*--------------------------------------------------------------------------*/
+
+static void bench_memory (void)
+{                                   /* --- memory hierarchy probe */
+  const CPUMEM    *m;               /* measured memory hierarchy */
+  const CPUMEMLVL *v;               /* to traverse the levels */
+  int             i, k;             /* loop variables */
+  double          t;                /* time of the probe */
+  char            name[64], lvl[16];/* name of a measurement, level */
+
+  t = now();                        /* time the probe (first call) */
+  m = cpuinfo_memory();             /* and a cached call */
+  report("probe/cold", now() -t, "s");
+  t = now();
+  for (i = 0; i < REPS; i++) sink = (cpuinfo_memory() == m);
+  report("probe/warm", (now() -t) *1e9 /REPS, "ns");
+  if (!m) return;                   /* check for a result */
+  for (i = 0; i < m->nlevels; i++) {
+    v = m->levels +i;               /* traverse the levels */
+    if (v->level > 0) sprintf(lvl, "L%d", v->level);
+    else              strcpy(lvl, "mem");
+    sprintf(name, "%s/latency",  lvl); report(name, v->latency, "ns");
+    sprintf(name, "%s/read",     lvl); report(name, v->read,    "GB/s");
+    sprintf(name, "%s/write",    lvl); report(name, v->write,   "GB/s");
+    sprintf(name, "%s/readall",  lvl); report(name, v->readall, "GB/s");
+    sprintf(name, "%s/writeall", lvl); report(name, v->writeall,"GB/s");
+    if (v->capacity < 0) continue;
+    sprintf(name, "%s/capacity", lvl);
+    report(name, (double)v->capacity /1024, "KB");
+  }
+  for (k = 0; k < m->nscale; k++) { /* report the scaling */
+    sprintf(name, "mem/read/%d", m->scalethr[k]);
+    report(name, m->scalebw[k], "GB/s");
+  }
+}  /* bench_memory() */
+
+/*--------------------------------------------------------------------------*/
+
+static const struct {               /* --- benchmark suites --- */
+  const char *name;                 /* name of the suite */
+  void      (*run)(void);           /* function running the suite */
+} suites[] = {
+  { "query", bench_query },         /* cost per has*() query */
+  { "api",   bench_api   },         /* cold/warm cost of all queries */
+  { "cpuid", bench_cpuid },         /* raw latency of cpuid */
+  { "disp",  bench_disp  },         /* dispatched vs. direct calls */
+  { "place", bench_place },         /* thread placement policies */
+  { "enum",  bench_enum  },         /* enumeration of the topology */
+  { "backend", bench_backend },     /* topology backends */
+  { "file",  bench_file  },         /* import of a description */
+  { "timer", bench_timer },         /* cost of reading a timer */
+  { "current", bench_current },     /* current cpu, sharded counter */
+  { "alloc", bench_alloc },         /* padding and node placement */
+  { "memory", bench_memory },       /* memory hierarchy probe */
+};
+
+/*--------------------------------------------------------------------------*/
+
+int main (int argc, char *argv[])
+{                                   /* --- main function */
+  int i, k, a = 1;                  /* loop variables, first suite arg. */
+  int n = (int)(sizeof(suites)/sizeof(*suites));
+
+  prog = argv[0];                   /* note the program path */
+  if ((argc > 1) && (strcmp(argv[1], "-m") == 0)) {
+    mach = 1; a = 2;                /* check for machine-readable */
+    printf("suite,name,value,unit\n");   /* output and print header */
+  }
+  for (i = 0; i < n; i++) {         /* traverse the suites */
+    if (argc > a) {                 /* if suites are given, */
+      for (k = a; k < argc; k++)    /* check whether this one is listed */
+        if (strcmp(argv[k], suites[i].name) == 0) break;
+      if (k >= argc) continue;
+    }
+    suite = suites[i].name;         /* note the suite name */
+    suites[i].run();                /* run the benchmark suite */
+    fflush(stdout);                 /* (before forking processes) */
+  }
+  return 0;                         /* return 'ok' */
+}  /* main() */
+
+/*----------------------------------------------------------------------------
+Usage: cpubench [-m] [suite ...]
+  Runs the given benchmark suites (default: all). Every measurement is
+  printed as one line with suite, name, value and unit; with -m the
+  lines are comma-separated (with a header line), so that they can be
+  compared between builds to catch regressions. Cold costs are measured
+  in fresh processes (cpucold <query>), so they include the
+  loading of the snapshot, topology etc. on first use; warm costs are
+  averages over repeated calls.
+----------------------------------------------------------------------------*/
+#else  /* #ifndef CPUBENCH_COLD */
+
+static int cold (const char *name)
+{                                   /* --- time a single first call */
+  int    i;                         /* loop variable */
+  double t;                         /* time of the call */
+
+  for (i = 0; i < QUERYCNT; i++)    /* find the query */
+    if (strcmp(queries[i].name, name) == 0) break;
+  if (i >= QUERYCNT) return -1;     /* (this runs in a fresh process, */
+  t = now();                        /* so nothing is initialized yet) */
+  sink = queries[i].fn();
+  printf("%.1f\n", (now() -t) *1e9);
+  return 0;                         /* print the time in nanoseconds */
+}  /* cold() */
+
+/*--------------------------------------------------------------------------*/
+
+int main (int argc, char *argv[])
+{                                   /* --- time a first call */
+  if (argc != 2) {                  /* check the arguments */
+    fprintf(stderr, "usage: %s query\n", argv[0]); return 1; }
+  return cold(argv[1]) ? 1 : 0;     /* time a single first call */
+}  /* main() */
+
+/*----------------------------------------------------------------------------
+  cpubench -DCPUBENCH_COLD is built as cpucold, which contains only the
+  queries (no dispatched functions, whose ifunc resolvers would load
+  the feature snapshot before main() is entered). It is run by the api
+  suite of cpubench to measure the cost of the first call of a query.
+----------------------------------------------------------------------------*/
+#endif  /* #ifndef CPUBENCH_COLD .. #else .. */
@@ -0,0 +1,93 @@
+/*----------------------------------------------------------------------------
+  File    : cpudisp.c
+  Contents: runtime dispatch of ISA-specific function implementations
+  Author  : Kristian Loewe, Christian Borgelt
+----------------------------------------------------------------------------*/
+#include <stddef.h>
+
+#include "cpudisp.h"
+
+/*----------------------------------------------------------------------------
+  Functions
+----------------------------------------------------------------------------*/
+
+int cpudisp_check (const char *feats)
+{                                   /* --- check for a set of features */
+  char name[32];                    /* buffer for a feature name */
+  int  n, f;                        /* name length, feature index */
+
+  if (!feats) return 1;             /* no features are always available */
+  while (*feats) {                  /* traverse the feature names */
+    for (n = 0; feats[n] && (feats[n] != ','); n++)
+      if (n < (int)sizeof(name)-1) name[n] = feats[n];
+    if (n >= (int)sizeof(name)) return 0;
+    name[n] = 0;                    /* copy the next feature name */
+    if (n > 0) {                    /* skip empty names */
+      f = cpuinfo_featbyname(name); /* look up the feature and */
+      if ((f < 0) || !cpuinfo_has(f)) return 0;
+    }                               /* check whether it is available */
+    feats += n;                     /* go to the next feature name */
+    if (*feats == ',') feats++;
+  }
+  return 1;                         /* all features are available */
+}  /* cpudisp_check() */
+
+/*--------------------------------------------------------------------------*/
+
+CPUFN cpudisp_select (const CPUIMPL *impls, int cnt)
+{                                   /* --- select best implementation */
+  int i;                            /* loop variable */
+  for (i = 0; i < cnt; i++)         /* return the first implementation */
+    if (cpudisp_check(impls[i].feats))  /* whose features */
+      return impls[i].fn;           /* are all available */
+  return NULL;                      /* no implementation is usable */
+}  /* cpudisp_select() */
+
+/*--------------------------------------------------------------------------*/
+
+int cpudisp_init (const CPUSLOT *slots, int cnt)
+{                                   /* --- resolve a dispatch table */
+  int   i, r = 0;                   /* loop variable, result */
+  CPUFN fn;                         /* selected implementation */
+
+  for (i = 0; i < cnt; i++) {       /* traverse the table entries */
+    fn = cpudisp_select(slots[i].impls, slots[i].cnt);
+    if (!fn) { r = -1; continue; }  /* select an implementation */
+    #ifdef _MSC_VER                 /* and store it in the slot */
+    *(CPUFN volatile*)slots[i].slot = fn;
+    #else                           /* (atomic store, so that other */
+    __atomic_store_n(slots[i].slot, fn, __ATOMIC_RELEASE);
+    #endif                          /* threads see either the old */
+  }                                 /* or the new function pointer) */
+  return r;                         /* return the error status */
+}  /* cpudisp_init() */
+
+/*----------------------------------------------------------------------------
+Additional info (dispatch):
+  Each dispatched function is described by a list of implementations,
+  ordered from the most to the least demanding one, each annotated with
+  the (comma-separated) names of the features it needs, as accepted by
+  cpuinfo_featbyname(). An implementation with an empty feature list is
+  always usable and should come last as a generic fallback.
+  The selection is done once, either by cpudisp_init() on a table of
+  function pointers (which may also be done lazily from a stub that the
+  pointer initially refers to) or by a GNU indirect function resolver
+  (CPUDISP_IFUNC), which the dynamic linker runs during relocation.
+  Afterwards every call is a single indirect call without any feature
+  check. The resolver of an executable runs before the C library is
+  initialized (no constructor has run yet, environ is still NULL, so
+  getenv() returns NULL). It calls cpuinfo_has(), which takes the
+  feature snapshot: cpuid and xgetbv, memset() and memcpy(), the
+  arch_prctl() system call for the AMX permission, and, if a
+  description file is set, stdio and malloc() to import it. With glibc
+  these work at this point, as libc.so is relocated before the
+  executable. The snapshot is taken only once, so the cpuinfo module
+  reads CPUINFO_FEATURES and CPUINFO_FILE from /proc/self/environ while
+  environ is NULL. Otherwise the masks would be lost for the whole
+  process. The resolvers of CPUDISP_IFUNC only call cpudisp_select();
+  hand-written ones must not rely on getenv() or on other parts of the
+  C library that need its initialization. Tables that cpudisp_init()
+  sets up from main() are not subject to these restrictions.
+  gcc.gnu.org/onlinedocs/gcc/Common-Function-Attributes.html (ifunc)
+  sourceware.org/glibc/wiki/GNU_IFUNC
+----------------------------------------------------------------------------*/
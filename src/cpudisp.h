@@ -0,0 +1,50 @@
+/*----------------------------------------------------------------------------
+  File    : cpudisp.h
+  Contents: runtime dispatch of ISA-specific function implementations
+  Author  : Kristian Loewe, Christian Borgelt
+----------------------------------------------------------------------------*/
+#ifndef CPUDISP_H
+#define CPUDISP_H
+
+#include "cpuinfo.h"
+
+/*----------------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------------*/
+#define CPUDISP_FN(f)   ((CPUFN)(f))    /* cast to generic function */
+#define CPUDISP_CNT(a)  ((int)(sizeof(a)/sizeof(*(a))))
+
+#if defined __linux__ && defined __GNUC__ && defined __ELF__
+#define CPUDISP_HAVE_IFUNC  1       /* GNU indirect functions available */
+#define CPUDISP_IFUNC(ret, name, params, impls) \
+  static ret (*name##_resolve (void)) params \
+  { return (ret (*) params)cpudisp_select(impls, CPUDISP_CNT(impls)); } \
+  ret name params __attribute__((ifunc(#name "_resolve")))
+#else
+#define CPUDISP_HAVE_IFUNC  0       /* GNU indirect functions unavailable */
+#endif
+
+/*----------------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------------*/
+typedef void (*CPUFN) (void);       /* generic function pointer */
+
+typedef struct {                    /* --- ISA-specific implementation --- */
+  const char *feats;                /* required features ("avx2,fma3") */
+  CPUFN       fn;                   /* implementing function */
+} CPUIMPL;                          /* (ISA-specific implementation) */
+
+typedef struct {                    /* --- dispatch table entry --- */
+  CPUFN         *slot;              /* function pointer to set */
+  const CPUIMPL *impls;             /* implementations (best first) */
+  int           cnt;                /* number of implementations */
+} CPUSLOT;                          /* (dispatch table entry) */
+
+/*----------------------------------------------------------------------------
+  Functions
+----------------------------------------------------------------------------*/
+extern int   cpudisp_check  (const char *feats);
+extern CPUFN cpudisp_select (const CPUIMPL *impls, int cnt);
+extern int   cpudisp_init   (const CPUSLOT *slots, int cnt);
+
+#endif  /* #ifndef CPUDISP_H */
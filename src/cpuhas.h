@@ -0,0 +1,294 @@
+/*----------------------------------------------------------------------------
+  File    : cpuhas.h
+  Contents: processor feature checks folded at compile time
+  Author  : Kristian Loewe, Christian Borgelt
+----------------------------------------------------------------------------*/
+#ifndef CPUHAS_H
+#define CPUHAS_H
+
+#include "cpuinfo.h"
+
+/*----------------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------------*/
+#if defined __x86_64__ || defined _M_X64
+#define CPUHAS_X64  1               /* x86-64 baseline (psABI v1) */
+#else
+#define CPUHAS_X64  0
+#endif
+
+#if defined __MMX__ || CPUHAS_X64
+#define CPUHAS_MMX              1
+#else
+#define CPUHAS_MMX              0
+#endif
+#if defined __SSE__ || CPUHAS_X64
+#define CPUHAS_SSE              1
+#else
+#define CPUHAS_SSE              0
+#endif
+#if defined __SSE2__ || CPUHAS_X64
+#define CPUHAS_SSE2             1
+#else
+#define CPUHAS_SSE2             0
+#endif
+#if defined __SSE3__
+#define CPUHAS_SSE3             1
+#else
+#define CPUHAS_SSE3             0
+#endif
+#if defined __SSSE3__
+#define CPUHAS_SSSE3            1
+#else
+#define CPUHAS_SSSE3            0
+#endif
+#if defined __SSE4_1__
+#define CPUHAS_SSE41            1
+#else
+#define CPUHAS_SSE41            0
+#endif
+#if defined __SSE4_2__
+#define CPUHAS_SSE42            1
+#else
+#define CPUHAS_SSE42            0
+#endif
+#if defined __POPCNT__
+#define CPUHAS_POPCNT           1
+#else
+#define CPUHAS_POPCNT           0
+#endif
+#if defined __AVX__
+#define CPUHAS_AVX              1
+#else
+#define CPUHAS_AVX              0
+#endif
+#if defined __AVX2__
+#define CPUHAS_AVX2             1
+#else
+#define CPUHAS_AVX2             0
+#endif
+#if defined __FMA__
+#define CPUHAS_FMA3             1
+#else
+#define CPUHAS_FMA3             0
+#endif
+#if defined __AVX512F__
+#define CPUHAS_AVX512F          1
+#else
+#define CPUHAS_AVX512F          0
+#endif
+#if defined __AVX512CD__
+#define CPUHAS_AVX512CD         1
+#else
+#define CPUHAS_AVX512CD         0
+#endif
+#if defined __AVX512BW__
+#define CPUHAS_AVX512BW         1
+#else
+#define CPUHAS_AVX512BW         0
+#endif
+#if defined __AVX512DQ__
+#define CPUHAS_AVX512DQ         1
+#else
+#define CPUHAS_AVX512DQ         0
+#endif
+#if defined __AVX512VL__
+#define CPUHAS_AVX512VL         1
+#else
+#define CPUHAS_AVX512VL         0
+#endif
+#if defined __BMI__
+#define CPUHAS_BMI1             1
+#else
+#define CPUHAS_BMI1             0
+#endif
+#if defined __BMI2__
+#define CPUHAS_BMI2             1
+#else
+#define CPUHAS_BMI2             0
+#endif
+#if defined __LZCNT__
+#define CPUHAS_LZCNT            1
+#else
+#define CPUHAS_LZCNT            0
+#endif
+#if defined __F16C__
+#define CPUHAS_F16C             1
+#else
+#define CPUHAS_F16C             0
+#endif
+#if defined __ADX__
+#define CPUHAS_ADX              1
+#else
+#define CPUHAS_ADX              0
+#endif
+#if defined __SHA__
+#define CPUHAS_SHA              1
+#else
+#define CPUHAS_SHA              0
+#endif
+#if defined __AES__
+#define CPUHAS_AES              1
+#else
+#define CPUHAS_AES              0
+#endif
+#if defined __VAES__
+#define CPUHAS_VAES             1
+#else
+#define CPUHAS_VAES             0
+#endif
+#if defined __VPCLMULQDQ__
+#define CPUHAS_VPCLMULQDQ       1
+#else
+#define CPUHAS_VPCLMULQDQ       0
+#endif
+#if defined __GFNI__
+#define CPUHAS_GFNI             1
+#else
+#define CPUHAS_GFNI             0
+#endif
+#if defined __AVX512IFMA__
+#define CPUHAS_AVX512IFMA       1
+#else
+#define CPUHAS_AVX512IFMA       0
+#endif
+#if defined __AVX512VNNI__
+#define CPUHAS_AVX512VNNI       1
+#else
+#define CPUHAS_AVX512VNNI       0
+#endif
+#if defined __AVX512BF16__
+#define CPUHAS_AVX512BF16       1
+#else
+#define CPUHAS_AVX512BF16       0
+#endif
+#if defined __AVX512FP16__
+#define CPUHAS_AVX512FP16       1
+#else
+#define CPUHAS_AVX512FP16       0
+#endif
+#if defined __AVX512VBMI__
+#define CPUHAS_AVX512VBMI       1
+#else
+#define CPUHAS_AVX512VBMI       0
+#endif
+#if defined __AVX512VBMI2__
+#define CPUHAS_AVX512VBMI2      1
+#else
+#define CPUHAS_AVX512VBMI2      0
+#endif
+#if defined __AVX512BITALG__
+#define CPUHAS_AVX512BITALG     1
+#else
+#define CPUHAS_AVX512BITALG     0
+#endif
+#if defined __AVX512VPOPCNTDQ__
+#define CPUHAS_AVX512VPOPCNTDQ  1
+#else
+#define CPUHAS_AVX512VPOPCNTDQ  0
+#endif
+#if defined __AVXVNNI__
+#define CPUHAS_AVXVNNI          1
+#else
+#define CPUHAS_AVXVNNI          0
+#endif
+#if defined __AVX10_1__
+#define CPUHAS_AVX10            1
+#else
+#define CPUHAS_AVX10            0
+#endif
+#define CPUHAS_AMXTILE          0   /* AMX is never folded, as it */
+#define CPUHAS_AMXINT8          0   /* needs a per-process permission */
+#define CPUHAS_AMXBF16          0   /* (see cpuinfo_xstate()) */
+#if defined __MOVDIRI__
+#define CPUHAS_MOVDIRI          1
+#else
+#define CPUHAS_MOVDIRI          0
+#endif
+#if defined __SERIALIZE__
+#define CPUHAS_SERIALIZE        1
+#else
+#define CPUHAS_SERIALIZE        0
+#endif
+#if CPUHAS_X64
+#define CPUHAS_FPU              1
+#else
+#define CPUHAS_FPU              0
+#endif
+#if CPUHAS_X64
+#define CPUHAS_CX8              1
+#else
+#define CPUHAS_CX8              0
+#endif
+#if CPUHAS_X64
+#define CPUHAS_CMOV             1
+#else
+#define CPUHAS_CMOV             0
+#endif
+#if CPUHAS_X64
+#define CPUHAS_FXSR             1
+#else
+#define CPUHAS_FXSR             0
+#endif
+#if CPUHAS_X64
+#define CPUHAS_SYSCALL          1
+#else
+#define CPUHAS_SYSCALL          0
+#endif
+#if defined __GCC_HAVE_SYNC_COMPARE_AND_SWAP_16
+#define CPUHAS_CX16             1
+#else
+#define CPUHAS_CX16             0
+#endif
+#if defined __LAHF_SAHF__
+#define CPUHAS_LAHF             1
+#else
+#define CPUHAS_LAHF             0
+#endif
+#if defined __MOVBE__
+#define CPUHAS_MOVBE            1
+#else
+#define CPUHAS_MOVBE            0
+#endif
+#if defined __AVX__
+#define CPUHAS_OSXSAVE          1
+#else
+#define CPUHAS_OSXSAVE          0
+#endif
+#if defined __RDTSCP__
+#define CPUHAS_RDTSCP           1
+#else
+#define CPUHAS_RDTSCP           0
+#endif
+#if defined __RDPID__
+#define CPUHAS_RDPID            1
+#else
+#define CPUHAS_RDPID            0
+#endif
+
+/* CPU_HAS(f) is a compile time constant 1 if the target flags of the */
+/* build guarantee that feature f can be used (e.g. -mavx2), otherwise */
+/* it checks the runtime snapshot; f is the suffix of a CPU_* index */
+#define CPU_HAS(f)  (CPUHAS_##f || cpuinfo_has(CPU_##f))
+
+#endif  /* #ifndef CPUHAS_H */
+/*----------------------------------------------------------------------------
+Additional info (CPU_HAS):
+  Since CPUHAS_<f> is a constant, a branch like
+    if (CPU_HAS(AVX2)) avx2_kernel(...); else sse2_kernel(...);
+  is resolved by the compiler in builds for a target that includes the
+  feature, and the fallback disappears from the code. The CPUHAS_<f>
+  constants can also be used in #if directives, e.g. to leave out the
+  fallback implementations entirely. Features are folded only if the
+  target guarantees that they can be used; masks set with
+  CPUINFO_FEATURES cannot disable them (code compiled for the target
+  uses them anyway). The AMX features are not folded although targets
+  like -march=sapphirerapids define __AMX_TILE__ etc.: on Linux a
+  process must request the permission for the tile state before the
+  first AMX instruction (otherwise it raises SIGILL), which is done by
+  cpuinfo_xstate(CPU_XSTATE_AMX). Until then CPU_HAS(AMXTILE) etc.
+  return 0, so code for AMX has to call cpuinfo_xstate() first.
+  OSXSAVE is implied by AVX, as code compiled for AVX needs the OS
+  support. The GCC/Clang predefined macros are listed with
+    gcc -march=native -dM -E - < /dev/null
+----------------------------------------------------------------------------*/
@@ -3,17 +3,30 @@
   Contents: processor information queries
   Author  : Kristian Loewe, Christian Borgelt
 ----------------------------------------------------------------------------*/
+#if defined __linux__ && !defined _GNU_SOURCE
+#  define _GNU_SOURCE               /* needed for sched_setaffinity() */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
 #ifdef _WIN32                       /* if Microsoft Windows system */
 #  include <windows.h>
+#  include <intrin.h>               /* needed for __rdtsc(), __rdtscp() */
 #else
 #  include <unistd.h>
-#  include <stdio.h>
-#  include <stdlib.h>
-#  include <stdint.h>
+#  include <sched.h>
+#  include <pthread.h>              /* needed for cpuinfo_memory() */
 #  ifdef __APPLE__                  /* if Apple Mac OS system */
 #    include <sys/sysctl.h>
 #    include <sys/types.h>
 #  elif defined __linux__           /* if Linux system */
+#    include <fcntl.h>             /* needed for cpuinfo_refresh() */
+#    include <sys/syscall.h>       /* needed for arch_prctl() */
+#    include <sys/mman.h>          /* needed for cpuinfo_nodealloc() */
 #    ifdef HAVE_HWLOC
 #      include <hwloc.h>            /* needed for corecntHwloc() */
 #    endif
@@ -34,6 +47,64 @@
                           fprintf(stderr, __VA_ARGS__); } while(0)
 #endif
 
+#ifdef _MSC_VER                     /* atomic operations for once-only */
+#define ATOMIC_LOAD(p)      (*(volatile long*)(p))   /* initialization */
+#define ATOMIC_STORE(p,v)   (*(volatile long*)(p) = (v))
+#define ATOMIC_CAS(p,o,n)   (InterlockedCompareExchange(p, n, o) == (o))
+#define ATOMIC_LOADP(p)     (*(void* volatile*)(p))  /* for pointers */
+#define ATOMIC_STOREP(p,v)  (*(void* volatile*)(p) = (v))
+#define SPIN_PAUSE()        YieldProcessor()
+#else
+#define ATOMIC_LOAD(p)      __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define ATOMIC_STORE(p,v)   __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#define ATOMIC_CAS(p,o,n)   __sync_bool_compare_and_swap(p, o, n)
+#define ATOMIC_LOADP(p)     __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define ATOMIC_STOREP(p,v)  __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#define SPIN_PAUSE()        __builtin_ia32_pause()
+#endif
+
+#ifndef BACKEND_DEFAULT             /* default backend of the counts */
+#define BACKEND_DEFAULT  CPU_BACKEND_AUTO
+#endif
+
+#define LF_1         0              /* indices of the cpuid leaves */
+#define LF_7         1              /* that are stored in the snapshot */
+#define LF_7_1       2              /* (leaf 1, leaf 7 subleaves 0/1, */
+#define LF_X1        3              /* extended leaf 0x80000001) */
+#define LF_CNT       4
+
+#define CPUDIR   "/sys/devices/system/cpu/"
+#define TOPODIR  CPUDIR "cpu%d/topology/"
+#define CACHEDIR CPUDIR "cpu%d/cache/index%d/"
+#define CACHEMAX    16              /* max. number of cache descriptions */
+#define NODEDIR  "/sys/devices/system/node/"
+#define WATCHMAX    16              /* max. number of watched files */
+#define FNVINIT     0xcbf29ce484222325ULL   /* FNV-1a offset basis */
+#define FILEMAGIC   "CPUINFO"       /* magic string of a description */
+#define FILEVERSION 2               /* version of the file format */
+#define FILECPUMAX  (1 << 20)       /* max. number of cpus in a file */
+#define MEMSTEPS    (1L << 20)      /* pointer chase steps per level */
+#define MEMBYTES    ((int64_t)1 << 28)  /* bytes per bandwidth test */
+#define MEMMIN      ((int64_t)1 << 26)  /* min. working set of memory */
+#define MEMMAX      ((int64_t)1 << 28)  /* max. working set of memory */
+#define MEMTHRMIN   ((int64_t)1 << 22)  /* min. memory set per thread */
+#define MEMTIME     2e7             /* max. time of a latency test [ns] */
+#define MEM_READ    0               /* probe modes: read bandwidth, */
+#define MEM_WRITE   1               /* write bandwidth, */
+#define MEM_LAT     2               /* latency (pointer chase) */
+
+#define XS_YMM   CPU_XSTATE_YMM     /* abbreviations for the table */
+#define XS_ZMM   CPU_XSTATE_ZMM     /* of feature definitions */
+#define XS_AMX   CPU_XSTATE_AMX
+#define ARCH_GET_XCOMP_PERM  0x1022 /* arch_prctl() codes for the */
+#define ARCH_REQ_XCOMP_PERM  0x1023 /* permission to use AMX tiles */
+#define XFEATURE_XTILEDATA   18     /* (not in all libc headers) */
+
+#define EAX          0              /* indices of the registers */
+#define EBX          1              /* in a cpuid result array */
+#define ECX          2
+#define EDX          3
+
 /*----------------------------------------------------------------------------
   Type Definitions
 ----------------------------------------------------------------------------*/
@@ -42,12 +113,195 @@ typedef struct {                    /* --- processor ids --- */
   int core;                         /* core     id */
 } PROCIDS;                          /* (processor ids) */
 
+typedef struct {                    /* --- raw ids of a logical cpu --- */
+  int cpu;                          /* logical processor number (OS) */
+  int apic;                         /* x2APIC id (-1: unknown) */
+  int xpkg, xdie, xcore;            /* ids derived from the x2APIC id */
+  int spkg, sdie, score;            /* ids read from sysfs */
+  int pkg,  die,  core;             /* ids used to build the topology */
+  int xtype;                        /* core type from cpuid leaf 0x1a */
+  int type, cap;                    /* core type and capacity */
+} RAWIDS;                           /* (raw ids of a logical cpu) */
+
+typedef struct {                    /* --- placement key --- */
+  int cpu;                          /* logical processor number */
+  int k[3];                         /* sort keys (most significant first) */
+} PLACEKEY;                         /* (placement key) */
+
+typedef struct {                    /* --- feature definition --- */
+  char name[16];                    /* feature name (lower case) */
+  int  leaf;                        /* cpuid leaf index (LF_*) */
+  int  reg;                         /* register index (EAX..EDX) */
+  int  bit;                         /* bit index in register */
+  uint32_t xs;                      /* XCR0 state needed for the feature */
+} FEATDEF;                          /* (feature definition) */
+
+typedef struct {                    /* --- description file header --- */
+  char     magic[8];                /* magic string (FILEMAGIC) */
+  uint32_t version;                 /* version of the format */
+  uint32_t sizes[5];                /* sizes of the stored structures */
+} FILEHDR;                          /* (description file header) */
+
+typedef struct {                    /* --- memory probe job --- */
+  const CPUSET *set;                /* cpus to run on (NULL: any) */
+  int      mode;                    /* probe mode (MEM_*) */
+  int      node;                    /* memory node (-1: first touch) */
+  size_t   size;                    /* working set size [bytes] */
+  size_t   line;                    /* cache line size [bytes] */
+  long     steps;                   /* pointer chase steps */
+  long     *ready;                  /* counter of ready threads */
+  long     *go;                     /* flag for a common start */
+  uint64_t beg, end;                /* start and end of the run [ticks] */
+  double   bytes;                   /* number of bytes transferred */
+  double   lat;                     /* latency per step [ns] */
+} MEMJOB;                           /* (memory probe job) */
+
+typedef struct {                    /* --- table of caches --- */
+  int      n;                       /* number of caches */
+  CPUCACHE *c;                      /* cache descriptions */
+} CACHETAB;                         /* (table of caches) */
+
+typedef struct {                    /* --- table of cpu locations --- */
+  int      n;                       /* number of logical cpus */
+  CPUCUR   *c;                      /* locations of the logical cpus */
+} CURTAB;                           /* (table of cpu locations) */
+
+typedef struct retired {            /* --- retired object --- */
+  struct retired *succ;             /* successor in the list */
+  void     *obj;                    /* the replaced object */
+  void     (*del)(void*);           /* function to delete it */
+} RETIRED;                          /* (retired object) */
+
 /*----------------------------------------------------------------------------
   Global Variables
 ----------------------------------------------------------------------------*/
-static int cpuinfo[4];              /* cpu information (cpuid) */
-static int peax = -1;               /* previous eax */
-static int pecx = -1;               /* previous ecx */
+static const FEATDEF featdefs[CPU_FEATCNT] = {
+  /* in the order of the CPU_* feature indices in cpuinfo.h */
+  { "mmx",             LF_1,   EDX, 23, 0      },
+  { "sse",             LF_1,   EDX, 25, 0      },
+  { "sse2",            LF_1,   EDX, 26, 0      },
+  { "sse3",            LF_1,   ECX,  0, 0      },
+  { "ssse3",           LF_1,   ECX,  9, 0      },
+  { "sse41",           LF_1,   ECX, 19, 0      },
+  { "sse42",           LF_1,   ECX, 20, 0      },
+  { "popcnt",          LF_1,   ECX, 23, 0      },
+  { "avx",             LF_1,   ECX, 28, XS_YMM },
+  { "avx2",            LF_7,   EBX,  5, XS_YMM },
+  { "fma3",            LF_1,   ECX, 12, XS_YMM },
+  { "avx512f",         LF_7,   EBX, 16, XS_ZMM },
+  { "avx512cd",        LF_7,   EBX, 28, XS_ZMM },
+  { "avx512bw",        LF_7,   EBX, 30, XS_ZMM },
+  { "avx512dq",        LF_7,   EBX, 17, XS_ZMM },
+  { "avx512vl",        LF_7,   EBX, 31, XS_ZMM },
+  { "bmi1",            LF_7,   EBX,  3, 0      },
+  { "bmi2",            LF_7,   EBX,  8, 0      },
+  { "lzcnt",           LF_X1,  ECX,  5, 0      },
+  { "f16c",            LF_1,   ECX, 29, XS_YMM },
+  { "adx",             LF_7,   EBX, 19, 0      },
+  { "sha",             LF_7,   EBX, 29, 0      },
+  { "aes",             LF_1,   ECX, 25, 0      },
+  { "vaes",            LF_7,   ECX,  9, XS_YMM },
+  { "vpclmulqdq",      LF_7,   ECX, 10, XS_YMM },
+  { "gfni",            LF_7,   ECX,  8, 0      },
+  { "avx512ifma",      LF_7,   EBX, 21, XS_ZMM },
+  { "avx512vnni",      LF_7,   ECX, 11, XS_ZMM },
+  { "avx512bf16",      LF_7_1, EAX,  5, XS_ZMM },
+  { "avx512fp16",      LF_7,   EDX, 23, XS_ZMM },
+  { "avx512vbmi",      LF_7,   ECX,  1, XS_ZMM },
+  { "avx512vbmi2",     LF_7,   ECX,  6, XS_ZMM },
+  { "avx512bitalg",    LF_7,   ECX, 12, XS_ZMM },
+  { "avx512vpopcntdq", LF_7,   ECX, 14, XS_ZMM },
+  { "avxvnni",         LF_7_1, EAX,  4, XS_YMM },
+  { "avx10",           LF_7_1, EDX, 19, XS_ZMM },
+  { "amxtile",         LF_7,   EDX, 24, XS_AMX },
+  { "amxint8",         LF_7,   EDX, 25, XS_AMX },
+  { "amxbf16",         LF_7,   EDX, 22, XS_AMX },
+  { "movdiri",         LF_7,   ECX, 27, 0      },
+  { "serialize",       LF_7,   EDX, 14, 0      },
+  { "fpu",             LF_1,   EDX,  0, 0      },
+  { "cx8",             LF_1,   EDX,  8, 0      },
+  { "cmov",            LF_1,   EDX, 15, 0      },
+  { "fxsr",            LF_1,   EDX, 24, 0      },
+  { "syscall",         LF_X1,  EDX, 11, 0      },
+  { "cx16",            LF_1,   ECX, 13, 0      },
+  { "lahf",            LF_X1,  ECX,  0, 0      },
+  { "movbe",           LF_1,   ECX, 22, 0      },
+  { "osxsave",         LF_1,   ECX, 27, 0      },
+  { "rdtscp",          LF_X1,  EDX, 27, 0      },
+  { "rdpid",           LF_7,   ECX, 22, 0      },
+};                                  /* (feature definitions) */
+
+static const char *const backends[CPU_BACKEND_CNT] = {
+  "auto", "sysfs", "proc", "cpuid", "hwloc", "file" };
+
+static const signed char levels[4][10] = {
+  /* features of the x86-64 psABI levels v1..v4 (-1 terminated) */
+  { CPU_CMOV, CPU_CX8, CPU_FPU, CPU_FXSR, CPU_MMX, CPU_SYSCALL,
+    CPU_SSE, CPU_SSE2, -1 },
+  { CPU_CX16, CPU_LAHF, CPU_POPCNT, CPU_SSE3, CPU_SSE41, CPU_SSE42,
+    CPU_SSSE3, -1 },
+  { CPU_AVX, CPU_AVX2, CPU_BMI1, CPU_BMI2, CPU_F16C, CPU_FMA3,
+    CPU_LZCNT, CPU_MOVBE, CPU_OSXSAVE, -1 },
+  { CPU_AVX512F, CPU_AVX512BW, CPU_AVX512CD, CPU_AVX512DQ,
+    CPU_AVX512VL, -1 },
+};                                  /* (microarchitecture levels) */
+
+static CPUINFO snap;                /* processor feature snapshot */
+static uint32_t amxpend[CPU_FEATWORDS];  /* AMX features held back */
+static long    state  = 0;          /* snapshot state (0: not initialized,
+                                       1: being initialized, 2: ready) */
+static CPUTOPO *topo   = NULL;     /* processor topology */
+static long    topost = 0;          /* topology state (as state) */
+static CACHETAB *caches = NULL;    /* cache descriptions */
+static long    cachest  = 0;        /* cache state (as state) */
+static CPUNUMA  *numa   = NULL;    /* NUMA node topology */
+static long    numast   = 0;        /* NUMA state (as state) */
+static CPUEFF   *eff    = NULL;    /* effective cpu resources */
+static const CPUEFF effnone;       /* (if they are not available) */
+static CPUTIMER timer;             /* tick timer */
+static long    timest   = 0;        /* timer state (as state) */
+static CURTAB  *curtab  = NULL;     /* locations of the logical cpus */
+static int     curmeth  = CPUCUR_NONE;  /* method to get the current cpu */
+static long    curst    = 0;        /* current cpu state (as state) */
+static const CPUCUR curnone = { -1, -1, -1, -1, -1 };
+static CPUMEM  *mem     = NULL;     /* measured memory hierarchy */
+static long    memst    = 0;        /* memory probe state (as state) */
+#ifdef _WIN32                       /* lock and condition for waiting */
+static SRWLOCK            waitlock = SRWLOCK_INIT; /* for slow loads */
+static CONDITION_VARIABLE waitcond = CONDITION_VARIABLE_INIT;
+#else                               /* (see waitonce()) */
+static pthread_mutex_t    waitlock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t     waitcond = PTHREAD_COND_INITIALIZER;
+#endif
+static volatile uint64_t memsink;  /* sink for probe results */
+static long    effst    = 0;        /* effective state (as state) */
+static char    root[256];           /* root directory for sysfs/procfs */
+static long    rootst   = 0;        /* root state (as state) */
+static long    cntst    = 0;        /* count state (as state) */
+static int     backend  = -1;       /* requested backend (CPU_BACKEND_*) */
+static int     cntsrc   = 0;        /* backend that gave the counts */
+static long    backst   = 0;        /* backend state (as state) */
+static long    gen      = 0;        /* generation of the loaded data */
+static long    refst    = 0;        /* refresh lock (1: refreshing) */
+static char    watch[WATCHMAX][256];/* files the effective resources */
+static int     watchfd[WATCHMAX];   /* depend on (cgroup files) and */
+static int     nwatch   = 0;        /* their descriptors (kept open) */
+static long    watchpid = 0;        /* process that opened them */
+static uint64_t effsig  = 0;        /* signature of the inputs */
+static int     onlfd    = -1;       /* descriptor of the online cpus */
+static uint64_t onlsig  = 0;        /* signature of the online cpus */
+static RETIRED *retired = NULL;     /* objects replaced by a refresh */
+static CPUHOOK *hook    = NULL;    /* notification hook for changes */
+static void    *hookdata = NULL;    /* data for the notification hook */
+static char    desc[256];           /* description file to import */
+static int     fileset  = 0;        /* whether file was set explicitly */
+static int     fileok   = 0;        /* whether the file was imported */
+static long    filest   = 0;        /* file state (as state) */
+static CPUINFO fsnap;               /* imported feature snapshot */
+#if defined __linux__ && defined HAVE_HWLOC
+static hwloc_topology_t hwtopo = NULL;  /* shared hwloc topology */
+static long    hwst     = 0;        /* hwloc state (as state) */
+#endif
 static int nphys  = 0;              /* # processors/packages/sockets */
 static int ncores = 0;              /* # processor cores */
 static int nprocs = 0;              /* # logical processors */
@@ -67,8 +321,6 @@ static void cpuid (int32_t info[4], int32_t eax, int32_t ecx)
                         "=c" (info[2]),
                         "=d" (info[3])
                         : "a" (eax), "c" (ecx));
-  peax = eax;
-  pecx = ecx;
 }  /* cpuid() */
 
 #endif  /* #ifdef _WIN32 .. #else .. */
@@ -78,444 +330,4125 @@ References (cpuid):
   stackoverflow.com/a/7495023
   msdn.microsoft.com/en-us/library/vstudio/hskdteyh%28v=vs.100%29.aspx
 ----------------------------------------------------------------------------*/
-#if defined __linux__ && defined HAVE_HWLOC
+#define FEATSET(c,f)   ((c)->feats[(f) >> 5] |=  (uint32_t)1 << ((f) & 31))
+#define FEATGET(c,f)  (((c)->feats[(f) >> 5] >> ((f) & 31)) & 1)
+#define FEATCLR(c,f)   ((c)->feats[(f) >> 5] &= ~((uint32_t)1 << ((f) & 31)))
 
-int corecntHwloc (void)
-{                                   /* --- number of processor cores */
-  int depth, cnt = -1;
-  hwloc_topology_t topology;        /* init and load topology */
-  hwloc_topology_init(&topology);
-  hwloc_topology_load(topology);
-  depth = hwloc_get_type_depth(topology, HWLOC_OBJ_CORE);
-                                    /* get the number of cores */
-  if (depth != HWLOC_TYPE_DEPTH_UNKNOWN)
-    cnt = (int)hwloc_get_nbobjs_by_depth(topology, (unsigned)depth);
-  hwloc_topology_destroy(topology); /* destroy topology object */
-  return cnt;                       /* return the number of cores */
-}  /* corecntHwloc() */
-
-#endif  /* #if defined __linux__ && defined HAVE_HWLOC */
-/*----------------------------------------------------------------------------
-Additional info and references (corecntHwloc):
-  This function depends on the Portable Hardware Locality (hwloc)
-  software package.
-  stackoverflow.com/a/12486105
-  open-mpi.org/projects/hwloc
-----------------------------------------------------------------------------*/
-#ifdef __linux__                    /* if Linux system */
+/*--------------------------------------------------------------------------*/
 
-static int cmpids (const void *p, const void *q)
-{                                   /* --- compare processor ids */
-  const PROCIDS *a = (PROCIDS*)p;   /* type the given pointers */
-  const PROCIDS *b = (PROCIDS*)q;   /* (PROCIDS array elements) */
-  if (a->phys < b->phys) return -1;
-  if (a->phys > b->phys) return +1;
-  if (a->core < b->core) return -1;
-  if (a->core > b->core) return +1;
-  return 0;                         /* return sign of difference */
-}  /* cmpids() */
+static uint64_t xgetbv (void)
+{                                   /* --- get extended control reg. 0 */
+  #ifdef _WIN32                     /* if Microsoft Windows system */
+  return _xgetbv(0);                /* use the compiler intrinsic */
+  #else                             /* if Linux/Unix system */
+  uint32_t lo, hi;                  /* low and high word of XCR0 */
+  __asm__ __volatile__ ("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0));
+  return ((uint64_t)hi << 32) | lo;
+  #endif
+}  /* xgetbv() */
 
 /*--------------------------------------------------------------------------*/
 
-static int enumerate (void)
-{                                   /* --- enumerate topology */
-  FILE    *fp;                      /* file for /proc/cpuinfo */
-  PROCIDS *pids;                    /* processor ids (physical & core) */
-  int n;                            /* # log. processors found in cpuinfo */
-  int i, p, c, np, nc;              /* loop variables */
+static int featidx (const char *name, size_t len)
+{                                   /* --- find a feature by name */
+  int        i;                     /* loop variable */
+  size_t     k;                     /* loop variable */
+  const char *d;                    /* to traverse the names */
 
-  /* determine number of logical processors (reference) */
-  #ifdef _SC_NPROCESSORS_ONLN       /* if glibc's sysconf is available */
-  nprocs = (int)sysconf(_SC_NPROCESSORS_ONLN);
-  #else
-  nprocs = -1;
+  for (i = 0; i < CPU_FEATCNT; i++) {
+    for (d = featdefs[i].name, k = 0; (k < len) && d[k]; k++)
+      if (((name[k] >= 'A') && (name[k] <= 'Z')
+           ? name[k] -'A' +'a' : name[k]) != d[k]) break;
+    if ((k >= len) && !d[k]) return i;
+  }                                 /* compare case-insensitively */
+  return -1;                        /* and return the feature index */
+}  /* featidx() */
+
+/*--------------------------------------------------------------------------*/
+
+static const char* envvar (const char *name, char *buf, size_t size)
+{                                   /* --- get an environment variable */
+  #ifdef __linux__                  /* if Linux system */
+  char    chunk[1024];              /* chunk of the environment */
+  ssize_t i, n;                     /* loop variable, # bytes read */
+  int     fd, k = 0, m = -1;        /* file, # matched chars, value len. */
+
+  if (environ) return getenv(name); /* if the C library is initialized */
+  fd = open("/proc/self/environ", O_RDONLY|O_CLOEXEC);
+  if (fd < 0) return NULL;          /* otherwise (ifunc resolver) read */
+  while ((n = read(fd, chunk, sizeof(chunk))) > 0) {  /* the initial */
+    for (i = 0; i < n; i++) {       /* environment of the process */
+      if (m >= 0) {                 /* if in the value, copy it */
+        if (!chunk[i]) break;       /* up to the terminating null */
+        if ((size_t)m < size-1) buf[m++] = chunk[i]; }
+      else if (!chunk[i]) k = 0;    /* restart at the next entry */
+      else if (k < 0)     continue; /* skip a non-matching entry */
+      else if (name[k])   k = (chunk[i] == name[k]) ? k+1 : -1;
+      else if (chunk[i] == '=') m = 0;
+      else k = -1;                  /* match the name and the '=' */
+    }
+    if (i < n) break;               /* stop at the end of the value */
+  }
+  close(fd);                        /* close the environment file */
+  if (m < 0) return NULL;           /* check for the variable */
+  buf[m] = 0; return buf;           /* and return its value */
+  #else                             /* if other system */
+  (void)buf; (void)size;            /* (ifunc resolvers are only */
+  return getenv(name);              /* used on Linux) */
   #endif
-  if (nprocs < 0) {                 /* abort if nprocs can't be determined */
-    nphys  = -1;
-    ncores = -1;
-    nprocs = -1;
-    return -1;
+}  /* envvar() */
+
+/*--------------------------------------------------------------------------*/
+
+static void featmask (CPUINFO *ci, const char *spec)
+{                                   /* --- mask features (environment) */
+  uint32_t   usable[CPU_FEATWORDS]; /* detected usable features */
+  const char *e;                    /* end of a feature name */
+  int        i, op;                 /* feature index, operation */
+
+  if (!spec) return;                /* check for a specification */
+  memcpy(usable, ci->feats, sizeof(usable));
+  while (*spec) {                   /* traverse the entries */
+    while ((*spec == ',') || (*spec == ' ')) spec++;
+    if ((*spec != '-') && (*spec != '+')) {
+      while (*spec && (*spec != ',') && (*spec != ' ')) spec++;
+      continue;                     /* skip malformed entries */
+    }
+    op = *spec++;                   /* get the operation */
+    for (e = spec; *e && (*e != ',') && (*e != ' '); e++);
+    if ((e -spec == 3) && (strncmp(spec, "all", 3) == 0)) {
+      for (i = 0; i < CPU_FEATWORDS; i++)
+        ci->feats[i] = (op == '-') ? 0 : usable[i]; }
+    else if ((i = featidx(spec, (size_t)(e -spec))) >= 0) {
+      ci->feats[i >> 5] &= ~((uint32_t)1 << (i & 31));
+      if (op == '+')                /* clear the feature and restore */
+        ci->feats[i >> 5] |= usable[i >> 5] & ((uint32_t)1 << (i & 31));
+    }                               /* it if it is to be enabled */
+    spec = e;                       /* (but only if it was detected, */
+  }                                 /* so features cannot be forced) */
+}  /* featmask() */
+
+/*--------------------------------------------------------------------------*/
+
+static int amxperm (void)
+{                                   /* --- check the AMX permission */
+  #ifdef __linux__                  /* if Linux system */
+  unsigned long perm = 0;           /* permitted state components */
+  return (syscall(SYS_arch_prctl, ARCH_GET_XCOMP_PERM, &perm) == 0)
+      && (perm & (1ul << XFEATURE_XTILEDATA));
+  #else                             /* if other system */
+  return 1;                         /* no permission is needed */
+  #endif
+}  /* amxperm() */
+
+/*--------------------------------------------------------------------------*/
+
+static void probe (CPUINFO *ci)
+{                                   /* --- read all relevant cpuid leaves */
+  int32_t info[4];                  /* result of a single cpuid call */
+  int32_t regs[LF_CNT][4];          /* stored cpuid leaves */
+  int     i, fam;                   /* loop variable, family */
+  char    spec[1024];               /* feature mask (environment) */
+
+  memset(ci,   0, sizeof(CPUINFO)); /* clear the snapshot and */
+  memset(regs, 0, sizeof(regs));    /* the stored cpuid leaves */
+  cpuid(info, 0, 0);                /* get max. leaf and vendor id */
+  ci->maxleaf = info[EAX];
+  memcpy(ci->vendor,   &info[EBX], 4);
+  memcpy(ci->vendor+4, &info[EDX], 4);
+  memcpy(ci->vendor+8, &info[ECX], 4);
+  if (ci->maxleaf >= 1) cpuid(regs[LF_1], 1, 0);
+  if (ci->maxleaf >= 7) cpuid(regs[LF_7], 7, 0);
+  if (regs[LF_7][EAX] >= 1) cpuid(regs[LF_7_1], 7, 1);
+  cpuid(info, (int32_t)0x80000000, 0);
+  ci->maxext = info[EAX];           /* get max. extended leaf */
+  if ((uint32_t)ci->maxext >= 0x80000001u)
+    cpuid(regs[LF_X1], (int32_t)0x80000001, 0);
+  if (((regs[LF_7_1][EDX] >> 19) & 1) && (ci->maxleaf >= 0x24)) {
+    cpuid(info, 0x24, 0);           /* get the AVX10 version */
+    ci->avx10ver = info[EBX] & 0xff;
   }
 
-  /* collect physical id and core id of each logical processor */
-  pids = calloc((size_t)nprocs, sizeof(PROCIDS));
-  if (!pids) return -1;             /* create array for processor ids */
-  fp = fopen("/proc/cpuinfo", "r");
-  if (!fp) { free(pids); return -1; }
-  for (c = p = n = 0; (c != EOF) && (n < nprocs); ) {
-    if      (fscanf(fp, "physical id : %d", &i) > 0) {
-      pids[n].phys = i; p |= 1; }
-    else if (fscanf(fp, "core id : %d",     &i) > 0) {
-      pids[n].core = i; p |= 2; }
-    if (p >= 3) { p = 0; n += 1; }
-    while (((c = fgetc(fp)) != EOF) && (c != '\n'));
+  fam = (regs[LF_1][EAX] >> 8) & 0xf;   /* decode the processor */
+  ci->family   = fam;                   /* signature (EAX of leaf 1) */
+  ci->model    = (regs[LF_1][EAX] >> 4) & 0xf;
+  ci->stepping =  regs[LF_1][EAX]       & 0xf;
+  if (fam == 0xf)               ci->family += (regs[LF_1][EAX] >> 20) & 0xff;
+  if (fam == 0xf || fam == 0x6) ci->model  += (regs[LF_1][EAX] >> 12) & 0xf0;
+  ci->lpmax = (regs[LF_1][EBX] >> 16) & 0xff;   /* EBX[23:16] */
+  ci->clsize = ((regs[LF_1][EBX] >> 8) & 0xff) *8;  /* EBX[15:8] */
+
+  if ((uint32_t)ci->maxext >= 0x80000007u) {
+    cpuid(info, (int32_t)0x80000007, 0);
+    ci->tscinv = (info[EDX] >> 8) & 1;
+  }                                 /* get invariant TSC flag */
+  if (ci->maxleaf >= 0x15) {        /* get TSC/crystal clock ratio */
+    cpuid(info, 0x15, 0);           /* and crystal clock frequency */
+    ci->tscden  = (uint32_t)info[EAX];
+    ci->tscnum  = (uint32_t)info[EBX];
+    ci->crystal = (uint32_t)info[ECX];
   }
-  fclose(fp);
-  if (n != nprocs) {                /* abort if the number of log. procs */
-    nphys  = -1;                    /* found differs from the reference */
-    ncores = -1;
-    nprocs = -1;
-    free(pids);
-    return -1;
+  if (ci->maxleaf >= 0x16) {        /* get the base frequency */
+    cpuid(info, 0x16, 0);
+    ci->basemhz = info[EAX] & 0xffff;
   }
 
-  /* sort the array of processor ids and determine the number of cores */
-  qsort(pids, (size_t)nprocs, sizeof(PROCIDS), cmpids);
-  p = pids[0].phys; c = pids[0].core;
-  nphys = ncores = 1;
-  for (i = np = nc = 0; i < n; i++) {
-    if (pids[i].phys == p) {   np += 1;
-      if (pids[i].core == c) { nc += 1; continue; }
-      DBGMSG("phys %d, core %2d: %d logical processor(s)\n", p, c, nc);
-      c = pids[i].core; nc = 1;
-      ncores += 1; continue;
-    }
-    DBGMSG("phys %d, core %d: %d logical processor(s)\n", p, c, nc);
-    DBGMSG("physical id %d: %d logical processor(s)\n", p, np);
-    p = pids[i].phys; np = 1;       /* count number of core ids */
-    c = pids[i].core; nc = 1;       /* per physical id and number */
-    ncores += 1; nphys += 1;        /* of different physical ids */
-  }
-  DBGMSG("phys %d, core %d: %d logical processor(s)\n", p, c, nc);
-  DBGMSG("physical id %d: %d logical processor(s)\n", p, np);
-  DBGMSG("number of physical processors: %d\n", nphys);
-  DBGMSG("number of cores: %d\n", ncores);
-  free(pids);
-  if (nprocs % ncores) {            /* check results for consistency */
-    nphys  = -1;
-    ncores = -1;
-    nprocs = -1;
-    return -1; }
-  else
-    return 0;
-}  /* enumerate() */
+  if ((regs[LF_1][ECX] >> 27) & 1)  /* if the OS uses XSAVE (OSXSAVE), */
+    ci->xcr0 = xgetbv();            /* get the enabled state components */
+  for (i = 0; i < CPU_FEATCNT; i++) {
+    if (!((regs[featdefs[i].leaf][featdefs[i].reg] >> featdefs[i].bit) & 1))
+      continue;                     /* collect the feature bits */
+    ci->present[i >> 5] |= (uint32_t)1 << (i & 31);
+    if ((ci->xcr0 & featdefs[i].xs) == featdefs[i].xs)
+      FEATSET(ci, i);               /* a feature is usable only if */
+  }                                 /* the OS saves its registers */
+  featmask(ci, envvar("CPUINFO_FEATURES", spec, sizeof(spec)));
+  memset(amxpend, 0, sizeof(amxpend));
+  if (!(ci->xcr0 & XS_AMX) || amxperm())
+    return;                         /* AMX instructions fault without */
+  for (i = 0; i < CPU_FEATCNT; i++) {   /* a permission, so hold back */
+    if (!(featdefs[i].xs & XS_AMX) || !FEATGET(ci, i))
+      continue;                     /* the AMX features until */
+    amxpend[i >> 5] |= (uint32_t)1 << (i & 31);
+    FEATCLR(ci, i);                 /* cpuinfo_xstate() requested it */
+  }
+}  /* probe() */
 
 /*--------------------------------------------------------------------------*/
 
-int physcnt (void)
-{                                   /* --- number of physical processors */
-  if (!nphys)
-    if (enumerate()) { return -1; }
-  return nphys;
-}  /* physcnt() */
+static void once (long *st, void (*load)(void))
+{                                   /* --- run a load function once */
+  if (ATOMIC_CAS(st, 0, 1)) {       /* if this thread won the race, */
+    load();                         /* run the load function and */
+    ATOMIC_STORE(st, 2); }          /* publish its result */
+  else {                            /* if another thread loads, */
+    while (ATOMIC_LOAD(st) != 2)    /* wait for it to publish */
+      SPIN_PAUSE();                 /* (loading takes at most a few */
+  }                                 /* milliseconds, so spinning is ok; */
+}  /* once() */                     /* for longer loads see waitonce()) */
 
 /*--------------------------------------------------------------------------*/
 
-int corecnt (void)
-{                                   /* --- number of processor cores */
-  if (!ncores)
-    if (enumerate()) { return -1; }
-  return ncores;
-}  /* corecnt() */
+static void waitonce (long *st, void (*load)(void))
+{                                   /* --- run a slow function once */
+  #ifdef _WIN32                     /* if Microsoft Windows system */
+  if (ATOMIC_CAS(st, 0, 1)) {       /* if this thread won the race, */
+    load();                         /* run the load function, */
+    AcquireSRWLockExclusive(&waitlock);
+    ATOMIC_STORE(st, 2);            /* publish its result */
+    WakeAllConditionVariable(&waitcond);
+    ReleaseSRWLockExclusive(&waitlock); }  /* and wake the waiters */
+  else {                            /* if another thread loads, */
+    AcquireSRWLockExclusive(&waitlock);    /* sleep until it has */
+    while (ATOMIC_LOAD(st) != 2)    /* published the result */
+      SleepConditionVariableSRW(&waitcond, &waitlock, INFINITE, 0);
+    ReleaseSRWLockExclusive(&waitlock);
+  }
+  #else                             /* if POSIX threads are available */
+  if (ATOMIC_CAS(st, 0, 1)) {       /* if this thread won the race, */
+    load();                         /* run the load function, */
+    pthread_mutex_lock(&waitlock);
+    ATOMIC_STORE(st, 2);            /* publish its result */
+    pthread_cond_broadcast(&waitcond);
+    pthread_mutex_unlock(&waitlock); }     /* and wake the waiters */
+  else {                            /* if another thread loads, */
+    pthread_mutex_lock(&waitlock);   /* sleep until it has */
+    while (ATOMIC_LOAD(st) != 2)    /* published the result */
+      pthread_cond_wait(&waitcond, &waitlock);
+    pthread_mutex_unlock(&waitlock);
+  }                                 /* (the waiters must not take cpu */
+  #endif                            /* time from the measurements) */
+}  /* waitonce() */
 
 /*--------------------------------------------------------------------------*/
 
-int proccnt (void)
-{                                   /* --- number of logical processors */
-  if (!nprocs)
-    if (enumerate()) { return -1; }
-  return nprocs;
-}  /* proccnt() */
+static int loaded (long *st)
+{                                   /* --- check whether data is loaded */
+  long s;                           /* state of the data */
+  while ((s = ATOMIC_LOAD(st)) == 1)/* wait for a running load */
+    SPIN_PAUSE();                   /* function to publish its result */
+  return s == 2;                    /* return whether data was loaded */
+}  /* loaded() */
 
 /*--------------------------------------------------------------------------*/
-#elif defined _WIN32                /* if Microsoft Windows system */
 
-int physcnt (void)
-{                                   /* --- number of physical processors */
-  return -1;                        /* not yet implemented for Windows */
-}  /* physcnt() */
+static void retire (void (*del)(void*), void *obj)
+{                                   /* --- retire a replaced object */
+  RETIRED *r;                       /* retired object */
+  if (!obj) return;                 /* (nothing to do for no object) */
+  r = malloc(sizeof(RETIRED));      /* note the object, so that it */
+  if (!r) return;                   /* can be deleted on a reset */
+  r->obj = obj; r->del = del;       /* (if this fails, the object */
+  r->succ = retired; retired = r;   /* is leaked, which is safe) */
+}  /* retire() */
 
 /*--------------------------------------------------------------------------*/
 
-int corecnt (void)
-{                                   /* --- number of processor cores */
-  return -1;                        /* not yet implemented for Windows */
-}  /* corecnt() */
+static void purge (void)
+{                                   /* --- delete the retired objects */
+  RETIRED *r;                       /* retired object */
+  while (retired) {                 /* traverse the retired objects */
+    r = retired; retired = r->succ; /* and delete them */
+    r->del(r->obj); free(r);
+  }
+}  /* purge() */
 
 /*--------------------------------------------------------------------------*/
 
-int proccnt (void)
-{                                   /* --- number of logical processors */
-  SYSTEM_INFO sysinfo;              /* system information structure */
-  GetSystemInfo(&sysinfo);          /* get system information */
-  return sysinfo.dwNumberOfProcessors;
-}  /* proccnt() */
+static void delcaches (void *p)
+{                                   /* --- delete a table of caches */
+  CACHETAB *c = p;                  /* table of caches */
+  int      i;                       /* loop variable */
+  for (i = 0; i < c->n; i++) free(c->c[i].inst);
+  free(c);                          /* delete the instance arrays */
+}  /* delcaches() */                /* and the table */
 
 /*--------------------------------------------------------------------------*/
-#elif defined __APPLE__             /* if Apple Mac OS system */
 
-int physcnt (void)
-{                                   /* --- number of physical processors */
-  int nphys;
-  size_t len = sizeof(nphys);
-  if (sysctlbyname("hw.packages", &nphys, &len, NULL, (size_t)0))
-    return -1;
-  return nphys;
-}  /* physcnt() */
+static void hdrinit (FILEHDR *h)
+{                                   /* --- initialize a file header */
+  memset(h, 0, sizeof(FILEHDR));    /* set the magic string, version */
+  strcpy(h->magic, FILEMAGIC);      /* and the structure sizes, so that */
+  h->version  = FILEVERSION;        /* files of other versions and */
+  h->sizes[0] = (uint32_t)sizeof(CPUINFO);  /* platforms are rejected */
+  h->sizes[1] = (uint32_t)sizeof(CPULOC);
+  h->sizes[2] = (uint32_t)offsetof(CPUCACHE, inst);
+  h->sizes[3] = (uint32_t)sizeof(CPUNODE);
+  h->sizes[4] = (uint32_t)sizeof(CPUEFF);
+}  /* hdrinit() */
 
 /*--------------------------------------------------------------------------*/
 
-int corecnt (void)
-{                                   /* --- number of processor cores */
-  int ncores;
-  size_t len = sizeof(ncores);
-  if (sysctlbyname("hw.physicalcpu", &ncores, &len, NULL, (size_t)0))
-    return -1;
-  return ncores;
-}  /* corecnt() */
+static int getblk (FILE *fp, void *p, size_t n)
+{ return (fread(p, 1, n, fp) == n) ? 0 : -1; }
 
 /*--------------------------------------------------------------------------*/
 
-int proccnt (void)
-{                                   /* --- number of logical processors */
-  int nproc;
-  size_t len = sizeof(nproc);
-  if (sysctlbyname("hw.logicalcpu", &nproc, &len, NULL, (size_t)0))
-    return -1;
-  return nproc;
-}  /* proccnt() */
+static int inrange (const int *v, int n, int lo, int hi)
+{                                   /* --- check the values of an array */
+  while (--n >= 0) if ((v[n] < lo) || (v[n] > hi)) return 0;
+  return 1;                         /* return whether all are in range */
+}  /* inrange() */
 
-#endif  /* #ifdef __linux__ .. #elif def. _WIN32 .. #elif def. __APPLE__ .. */
-/*----------------------------------------------------------------------------
-References (proccnt, Windows version):
-  Info on SYSTEM_INFO structure:
-  msdn.microsoft.com/en-us/library/windows/desktop/ms724958%28v=vs.85%29.aspx
-Additional info and references (proccnt, Linux version):
-  This function depends on glibc's sysconf extension.
-  glibc also provides a function to access _SC_NPROCESSORS_ONLN
-  in <sys/sysinfo.h> : get_nprocs which could be use instead of 
-  sysconf(_SC_NPROCESSORS_ONLN).
-  According to a comment by Joey Adams at stackoverflow.com/q/2693948
-  sysconf(_SC_NPROCESSORS_ONLN) relies on /proc/stat if that exist and on
-  /proc/cpuinfo if it doesn't.
-  gnu.org/software/libc/manual/html_node/Processor-Resources.html
-----------------------------------------------------------------------------*/
+/*--------------------------------------------------------------------------*/
 
-int proccntmax (void)
-{                                   /* --- max. number of logical processors
-                                     *     per physical processor */
-  int eax = 1;
-  int ecx = 0;
-  if ((eax != peax) || (ecx != pecx))
-    cpuid(cpuinfo, eax, ecx);
-  return (cpuinfo[1] >> 16) & 0xff; /* EBX[23:16] */
-}  /* proccntmax() */
+static int ascending (const int *v, int n)
+{                                   /* --- check for ascending values */
+  while (--n > 0) if (v[n] < v[n-1]) return 0;
+  return 1;                         /* return whether not descending */
+}  /* ascending() */
 
-/*----------------------------------------------------------------------------
-References (proccntmax):
-  "CPUID.1:EBX[23:16] represents the maximum number of addressable IDs
-  (initial APIC ID) that can be assigned to logical processors in a
-  physical package. The value may not be the same as the number of
-  logical processors that are present in the hardware of a physical package."
-  software.intel.com/en-us/articles/
-    intel-64-architecture-processor-topology-enumeration
-  software.intel.com/sites/default/files/63/1a/
-    Kuo_CpuTopology_rc1.rh1.final.pdf
-----------------------------------------------------------------------------*/
+/*--------------------------------------------------------------------------*/
 
-int hasMMX (void)
-{                                   /* --- check for MMX instructions */
-  int eax = 1;
-  int ecx = 0;
-  if ((eax != peax) || (ecx != pecx))
-    cpuid(cpuinfo, eax, ecx);
-  return (cpuinfo[3] & (1 << 23)) != 0;
-}  /* hasMMX() */
+static int chktopo (const CPUTOPO *t)
+{                                   /* --- check an imported topology */
+  const CPULOC *l;                  /* to traverse the locations */
+  int          i, k, n = 0;         /* loop variables, online cpus */
+
+  if (!inrange(t->ntype, CPU_CORE_TYPES, 0, t->ncores)
+  ||  !inrange(t->coreoff, t->ncores+1, 0, t->nprocs)
+  ||  !ascending(t->coreoff, t->ncores+1)
+  ||  (t->coreoff[0] != 0) || (t->coreoff[t->ncores] != t->nprocs)
+  ||  !inrange(t->corecpus, t->nprocs, 0, t->ncpus-1))
+    return -1;                      /* check the cores */
+  for (i = 0; i < t->ncpus; i++) {  /* traverse the logical cpus */
+    l = t->cpus +i;                 /* (all indices must be in range */
+    if ((l->type < 0) || (l->type >= CPU_CORE_TYPES)) return -1;
+    if (l->pkg < 0) continue;       /* for online cpus) */
+    if ((l->pkg  >= t->npkgs)
+    ||  (l->die  < 0) || (l->die  >= t->ndies)
+    ||  (l->core < 0) || (l->core >= t->ncores)
+    ||  (l->smt  < 0) || (l->smt  >= t->nprocs)) return -1;
+    n++;                            /* count the online cpus */
+  }
+  if (n != t->nprocs) return -1;    /* check the number of cpus */
+  for (k = 0; k < t->ncores; k++)   /* check the grouping by cores */
+    for (i = t->coreoff[k]; i < t->coreoff[k+1]; i++)
+      if (t->cpus[t->corecpus[i]].core != k) return -1;
+  return 0;                         /* return 'ok' */
+}  /* chktopo() */
 
 /*--------------------------------------------------------------------------*/
 
-int hasSSE (void)
-{                                   /* --- check for SSE instructions */
-  int eax = 1;
-  int ecx = 0;
-  if ((eax != peax) || (ecx != pecx))
-    cpuid(cpuinfo, eax, ecx);
-  return (cpuinfo[3] & (1 << 25)) != 0; /* EDX 25 */
-}  /* hasSSE() */
+static int chkcache (const CPUCACHE *c, const CPUTOPO *t)
+{                                   /* --- check an imported cache */
+  int i, k;                         /* loop variables */
+
+  if ((c->ninst < 0) || (c->ninst > t->nprocs)
+  ||  !inrange(c->inst, t->ncpus, -1, c->ninst-1)
+  ||  !inrange(c->instoff, c->ninst+1, 0, t->nprocs)
+  ||  !ascending(c->instoff, c->ninst+1) || (c->instoff[0] != 0)
+  ||  !inrange(c->instcpus, c->instoff[c->ninst], 0, t->ncpus-1))
+    return -1;                      /* check the instance arrays */
+  for (k = 0; k < c->ninst; k++)    /* check the grouping by instances */
+    for (i = c->instoff[k]; i < c->instoff[k+1]; i++)
+      if (c->inst[c->instcpus[i]] != k) return -1;
+  return 0;                         /* return 'ok' */
+}  /* chkcache() */
 
 /*--------------------------------------------------------------------------*/
 
-int hasSSE2 (void)
-{                                   /* --- check for SSE2 instructions */
-  int eax = 1;
-  int ecx = 0;
-  if ((eax != peax) || (ecx != pecx))
-    cpuid(cpuinfo, eax, ecx);
-  return (cpuinfo[3] & (1 << 26)) != 0; /* EDX 26 */
-}  /* hasSSE2() */
+static int chknuma (const CPUNUMA *m)
+{                                   /* --- check an imported NUMA topo. */
+  int i, k;                         /* loop variables */
+
+  if (!inrange(m->cpunode, m->ncpus, -1, m->nnodes-1)
+  ||  !inrange(m->nodeoff, m->nnodes+1, 0, m->ncpus)
+  ||  !ascending(m->nodeoff, m->nnodes+1) || (m->nodeoff[0] != 0)
+  ||  !inrange(m->nodecpus, m->nodeoff[m->nnodes], 0, m->ncpus-1))
+    return -1;                      /* check the node mappings */
+  for (k = 0; k < m->nnodes; k++) { /* traverse the nodes */
+    if ((m->nodes[k].ncpus < 0) || (m->nodes[k].ncpus > m->ncpus))
+      return -1;                    /* check the number of cpus */
+    for (i = m->nodeoff[k]; i < m->nodeoff[k+1]; i++)
+      if (m->cpunode[m->nodecpus[i]] != k) return -1;
+  }                                 /* check the grouping by nodes */
+  return 0;                         /* return 'ok' */
+}  /* chknuma() */
 
 /*--------------------------------------------------------------------------*/
 
-int hasSSE3 (void)
-{                                   /* --- check for SSE3 instructions */
-  int eax = 1;
-  int ecx = 0;
-  if ((eax != peax) || (ecx != pecx))
-    cpuid(cpuinfo, eax, ecx);
-  return (cpuinfo[2] & (1 <<  0)) != 0; /* ECX 0 */
-}  /* hasSSE3() */
+static int chkeff (const CPUEFF *e, const CPUTOPO *t)
+{                                   /* --- check imported eff. resources */
+  int i;                            /* loop variable */
+
+  if ((e->nallowed != cpuset_count(&e->allowed))
+  ||  (e->ncores   != cpuset_count(&e->cores))
+  ||  (e->nprocs    < 0) || (e->nprocs    > e->nallowed)
+  ||  (e->ncoreseff < 0) || (e->ncoreseff > e->ncores)
+  ||  (!(e->quota >= 0) && (e->quota != -1)))
+    return -1;                      /* check the counts and the quota */
+  for (i = 0; i < CPUSET_MAX; i++) {/* traverse the cpus and cores */
+    if (CPUSET_ISSET(&e->allowed, i)
+    &&  ((i >= t->ncpus) || (t->cpus[i].pkg < 0)))
+      return -1;                    /* allowed cpus must be online */
+    if (CPUSET_ISSET(&e->cores, i) && (i >= t->ncores))
+      return -1;                    /* and the cores must exist */
+  }                                 /* in the imported topology */
+  return 0;                         /* return 'ok' */
+}  /* chkeff() */
 
 /*--------------------------------------------------------------------------*/
 
-int hasSSSE3 (void)
-{                                   /* --- check for SSSE3 instructions */
-  int eax = 1;
-  int ecx = 0;
-  if ((eax != peax) || (ecx != pecx))
-    cpuid(cpuinfo, eax, ecx);
-  return (cpuinfo[2] & (1 <<  9)) != 0; /* ECX 9 */
-}  /* hasSSSE3() */
+static int readfile (FILE *fp)
+{                                   /* --- read a description file */
+  FILEHDR  h, x;                    /* file header, expected header */
+  CPUTOPO  *t = NULL;               /* imported topology */
+  CACHETAB *c = NULL;               /* imported caches */
+  CPUCACHE *d;                      /* to traverse the caches */
+  CPUNUMA  *m = NULL;               /* imported NUMA topology */
+  CPUEFF   *e;                      /* imported effective resources */
+  int      cnt[3], v[9];            /* counts, topology parameters */
+  int      i, n, k = 0, z;          /* loop variables, sizes */
+
+  hdrinit(&x);                      /* read and check the header */
+  if ((getblk(fp, &h, sizeof(h)) != 0) || (memcmp(&h, &x, sizeof(h)) != 0)
+  ||  (getblk(fp, &fsnap, sizeof(CPUINFO)) != 0)
+  ||  (getblk(fp, cnt, sizeof(cnt))        != 0)
+  ||  (getblk(fp, v,   sizeof(v))          != 0)
+  ||  !inrange(cnt, 3, -1, FILECPUMAX)
+  ||  !inrange(v, 2, 1, FILECPUMAX) || (v[1] > v[0])
+  ||  !inrange(v+2, 3, 1, v[1]))    /* (ncpus, nprocs, ncores, */
+    return -1;                      /*  ndies, npkgs must be valid) */
+  t = malloc(sizeof(CPUTOPO) +(size_t)v[0] *sizeof(CPULOC)
+                             +(size_t)(2*v[1]+1) *sizeof(int));
+  if (!t) return -1;                /* allocate the topology */
+  t->cpus     = (CPULOC*)(t+1);     /* (organized as in maketopo()) */
+  t->coreoff  = (int*)(t->cpus +v[0]);
+  t->corecpus = t->coreoff +v[1]+1;
+  t->ncpus  = v[0]; t->nprocs = v[1]; t->ncores = v[2];
+  t->ndies  = v[3]; t->npkgs  = v[4]; t->flags  = v[5] | CPUTOPO_FILE;
+  for (i = 0; i < CPU_CORE_TYPES; i++) t->ntype[i] = v[6+i];
+  if ((getblk(fp, t->cpus, (size_t)v[0] *sizeof(CPULOC)) != 0)
+  ||  (getblk(fp, t->coreoff,  (size_t)(v[2]+1) *sizeof(int)) != 0)
+  ||  (getblk(fp, t->corecpus, (size_t)v[1]     *sizeof(int)) != 0)
+  ||  (chktopo(t) != 0)
+  ||  (getblk(fp, &n, sizeof(n)) != 0) || (n < 0) || (n > CACHEMAX))
+    goto error;                     /* read the topology arrays */
+  z = v[0] +2*v[1] +1;              /* size of the instance arrays */
+  c = calloc(1, sizeof(CACHETAB) +(size_t)n *sizeof(CPUCACHE));
+  if (!c) goto error;               /* allocate the caches */
+  c->c = (CPUCACHE*)(c+1);          /* (organized as in loadcaches()) */
+  for (k = 0; k < n; k++) {         /* traverse the caches */
+    d = c->c +k; d->inst = malloc((size_t)z *sizeof(int));
+    if (!d->inst
+    ||  (getblk(fp, d, offsetof(CPUCACHE, inst)) != 0)
+    ||  (d->ninst < 0) || (d->ninst > v[1])
+    ||  (getblk(fp, d->inst, (size_t)z *sizeof(int)) != 0)) {
+      k++; goto error; }            /* read the cache description */
+    d->instoff  = d->inst    +v[0]; /* and its instances */
+    d->instcpus = d->instoff +v[1]+1;
+    if (chkcache(d, t) != 0) { k++; goto error; }
+  }
+  c->n = n;                         /* note the number of caches */
+  if ((getblk(fp, &i, sizeof(i)) != 0) || (i < 0) || (i > v[0]))
+    goto error;                     /* read the number of nodes */
+  if (i > 0) {                      /* if there is a NUMA topology */
+    m = malloc(sizeof(CPUNUMA) +(size_t)i *sizeof(CPUNODE)
+              +(size_t)(i*i +2*v[0] +i+1) *sizeof(int));
+    if (!m) goto error;             /* allocate the NUMA topology */
+    m->nnodes   = i;                /* (organized as in loadnuma()) */
+    m->nodes    = (CPUNODE*)(m+1);
+    m->dist     = (int*)(m->nodes +i);
+    m->ncpus    = v[0];
+    m->cpunode  = m->dist    +i*i;
+    m->nodeoff  = m->cpunode +v[0];
+    m->nodecpus = m->nodeoff +i+1;
+    if ((getblk(fp, m->nodes, (size_t)i *sizeof(CPUNODE)) != 0)
+    ||  (getblk(fp, m->dist, (size_t)(i*i +2*v[0] +i+1) *sizeof(int)) != 0)
+    ||  (chknuma(m) != 0))
+      goto error;                   /* read the node descriptions, */
+  }                                 /* distances and node mappings */
+  e = malloc(sizeof(CPUEFF));       /* read the effective resources */
+  if (!e || (getblk(fp, e, sizeof(CPUEFF)) != 0) || (chkeff(e, t) != 0)) {
+    free(e); goto error; }          /* (check all before publishing) */
+  nphys = cnt[0]; ncores = cnt[1]; nprocs = cnt[2];
+  ATOMIC_STOREP(&topo, t); ATOMIC_STOREP(&caches, c);
+  ATOMIC_STOREP(&numa, m); ATOMIC_STOREP(&eff,    e);
+  return 0;                         /* store the imported data */
+  error:                            /* on error, clean up */
+  while (--k >= 0) free(c->c[k].inst);
+  free(c); free(m); free(t);        /* delete the imported data */
+  return -1;                        /* return an error code */
+}  /* readfile() */
 
 /*--------------------------------------------------------------------------*/
 
-int hasSSE41 (void)
-{                                   /* --- check for SSE4.1 instructions */
-  int eax = 1;
-  int ecx = 0;
-  if ((eax != peax) || (ecx != pecx))
-    cpuid(cpuinfo, eax, ecx);
-  return (cpuinfo[2] & (1 << 19)) != 0; /* ECX 19 */
-}  /* hasSSE41() */
+static void initfile (void)
+{                                   /* --- import a description file */
+  const char *s;                    /* name from the environment */
+  char       buf[sizeof(desc)+1];   /* buffer for the name */
+  FILE       *fp;                   /* file to read */
+
+  if (!fileset) {                   /* if no file was set explicitly, */
+    s = envvar("CPUINFO_FILE", buf, sizeof(buf));
+    if (s && (strlen(s) < sizeof(desc))) strcpy(desc, s);
+  }                                 /* get it from the environment */
+  if (!*desc || !(fp = fopen(desc, "rb"))) return;
+  fileok = (readfile(fp) == 0);     /* read the description */
+  fclose(fp);
+  if (!fileok) DBGMSG("cannot import %s\n", desc);
+}  /* initfile() */
 
 /*--------------------------------------------------------------------------*/
 
-int hasSSE42 (void)
-{                                   /* --- check for SSE4.2 instructions */
-  int eax = 1;
-  int ecx = 0;
-  if ((eax != peax) || (ecx != pecx))
-    cpuid(cpuinfo, eax, ecx);
-  return (cpuinfo[2] & (1 << 20)) != 0; /* ECX 20 */
-}  /* hasSSE42() */
+static int fromfile (void)
+{                                   /* --- check for an imported file */
+  if (ATOMIC_LOAD(&filest) != 2) once(&filest, initfile);
+  return fileok;                    /* return whether data was imported */
+}  /* fromfile() */
 
 /*--------------------------------------------------------------------------*/
 
-int hasPOPCNT (void)
-{                                   /* --- check for popcnt instructions */
-  int eax = 1;
-  int ecx = 0;
-  if ((eax != peax) || (ecx != pecx))
-    cpuid(cpuinfo, eax, ecx);
-  return (cpuinfo[2] & (1 << 23)) != 0; /* ECX 23 */
-}  /* hasPOPCNT() */
+static void merge (CPUINFO *ci)
+{                                   /* --- merge the imported snapshot */
+  int i;                            /* loop variable */
+
+  ci->lpmax  = fsnap.lpmax;         /* take the description of the */
+  ci->clsize = fsnap.clsize;        /* machine from the file, but keep */
+  memcpy(ci->present, fsnap.present, sizeof(ci->present));
+  if (fsnap.avx10ver < ci->avx10ver)/* the local identification, OS */
+    ci->avx10ver = fsnap.avx10ver;  /* state and TSC data */
+  for (i = 0; i < CPU_FEATWORDS; i++) { /* keep only features that */
+    ci->feats[i] &= fsnap.feats[i]; /* are usable on this cpu and */
+    amxpend[i]   &= fsnap.feats[i]; /* (with a permission) in the */
+  }                                 /* imported description */
+}  /* merge() */
 
 /*--------------------------------------------------------------------------*/
 
-int hasAVX (void)
-{                                   /* --- check for AVX instructions */
-  int eax = 1;
-  int ecx = 0;
-  if ((eax != peax) || (ecx != pecx))
-    cpuid(cpuinfo, eax, ecx);
-  return (cpuinfo[2] & (1 << 28)) != 0; /* ECX 28 */
-}  /* hasAVX() */
+static void initsnap (void)
+{                                   /* --- initialize the snapshot */
+  probe(&snap);                     /* probe the processor and merge */
+  if (fromfile()) merge(&snap);     /* an imported description */
+}  /* initsnap() */
 
 /*--------------------------------------------------------------------------*/
 
-int hasAVX2 (void)
-{                                   /* --- check for AVX2 instructions */
-  int eax = 7;
-  int ecx = 0;
-  if ((eax != peax) || (ecx != pecx))
-    cpuid(cpuinfo, eax, ecx);
-  return (cpuinfo[1] & (1 <<  5)) != 0; /* EBX 5 */
-}  /* hasAVX2() */
+static inline const CPUINFO* getsnap (void)
+{                                   /* --- get the feature snapshot */
+  if (ATOMIC_LOAD(&state) != 2) once(&state, initsnap);
+  return &snap;                     /* initialize on first use only */
+}  /* getsnap() */
 
 /*--------------------------------------------------------------------------*/
 
-int hasFMA3 (void)
-{                                   /* --- check for FMA3 */
-  int eax = 1;
-  int ecx = 0;
-  if ((eax != peax) || (ecx != pecx))
-    cpuid(cpuinfo, eax, ecx);
-  return (cpuinfo[2] & (1 << 12)) != 0; /* ECX 12 */
-}  /* hasFMA3() */
+const CPUINFO* cpuinfo_get (void)
+{                                   /* --- get the feature snapshot */
+  return getsnap();
+}  /* cpuinfo_get() */
 
 /*--------------------------------------------------------------------------*/
 
-int hasAVX512f (void)
-{                                   /* --- check for AVX512f instructions */
-  int eax = 7;
-  int ecx = 0;
-  if ((eax != peax) || (ecx != pecx))
-    cpuid(cpuinfo, eax, ecx);
-  return (cpuinfo[1] & (1 << 16)) != 0; /* EBX 16 */
-}  /* hasAVX512f() */
+int cpuinfo_has (int feat)
+{                                   /* --- check for a processor feature */
+  if ((feat < 0) || (feat >= CPU_FEATCNT)) return 0;
+  return (int)FEATGET(getsnap(), feat);
+}  /* cpuinfo_has() */
 
 /*--------------------------------------------------------------------------*/
 
-int hasAVX512cd (void)
-{                                   /* --- check for AVX512cd instructions */
-  int eax = 7;
-  int ecx = 0;
-  if ((eax != peax) || (ecx != pecx))
-    cpuid(cpuinfo, eax, ecx);
-  return (cpuinfo[1] & (1 << 28)) != 0; /* EBX 28 */
-}  /* hasAVX512cd() */
+const char* cpuinfo_featname (int feat)
+{                                   /* --- get the name of a feature */
+  if ((feat < 0) || (feat >= CPU_FEATCNT)) return NULL;
+  return featdefs[feat].name;       /* return the (lower case) name */
+}  /* cpuinfo_featname() */
 
 /*--------------------------------------------------------------------------*/
 
-int hasAVX512bw (void)
-{                                   /* --- check for AVX512bw instructions */
-  int eax = 7;
-  int ecx = 0;
-  if ((eax != peax) || (ecx != pecx))
-    cpuid(cpuinfo, eax, ecx);
-  return (cpuinfo[1] & (1 << 30)) != 0; /* EBX 30 */
-}  /* hasAVX512bw() */
+int cpuinfo_featbyname (const char *name)
+{                                   /* --- get a feature by its name */
+  return featidx(name, strlen(name));
+}  /* cpuinfo_featbyname() */
 
 /*--------------------------------------------------------------------------*/
 
-int hasAVX512dq (void)
-{                                   /* --- check for AVX512dq instructions */
-  int eax = 7;
-  int ecx = 0;
-  if ((eax != peax) || (ecx != pecx))
-    cpuid(cpuinfo, eax, ecx);
-  return (cpuinfo[1] & (1 << 17)) != 0; /* EBX 17 */
-}  /* hasAVX512dq() */
+int cpuinfo_xstate (uint64_t mask)
+{                                   /* --- check for enabled OS state */
+  #ifdef __linux__                  /* if Linux system */
+  int i;                            /* loop variable */
+  #endif
+
+  if ((getsnap()->xcr0 & mask) != mask)
+    return 0;                       /* check the state components */
+  #ifdef __linux__                  /* if Linux system */
+  if (!(mask & CPU_XSTATE_AMX))     /* AMX tile data needs a per- */
+    return 1;                       /* process permission (Linux 5.16) */
+  if (!amxperm()                    /* check for an existing permission */
+  &&  (syscall(SYS_arch_prctl, ARCH_REQ_XCOMP_PERM,
+               XFEATURE_XTILEDATA) != 0))
+    return 0;                       /* and request it if necessary */
+  for (i = 0; i < CPU_FEATWORDS; i++)
+    if (amxpend[i]) __atomic_fetch_or(&snap.feats[i], amxpend[i],
+                                      __ATOMIC_RELEASE);
+  return 1;                         /* make the AMX features usable */
+  #else                             /* (they were held back) */
+  return 1;                         /* other systems need no permission */
+  #endif
+}  /* cpuinfo_xstate() */
 
 /*--------------------------------------------------------------------------*/
 
-int hasAVX512vl (void)
-{                                   /* --- check for AVX512vl instructions */
-  int eax = 7;
-  int ecx = 0;
-  if ((eax != peax) || (ecx != pecx))
-    cpuid(cpuinfo, eax, ecx);
-  return (cpuinfo[1] & (1 << 31)) != 0; /* EBX 31 */
-}  /* hasAVX512vl() */
+int cpuinfo_x86level (uint32_t missing[CPU_FEATWORDS])
+{                                   /* --- get the x86-64 level */
+  const CPUINFO *c = getsnap();     /* processor feature snapshot */
+  int l, i, f, n;                   /* level, loop variable, feature */
+
+  if (missing)                      /* clear the missing features */
+    memset(missing, 0, CPU_FEATWORDS *sizeof(uint32_t));
+  for (l = 0; l < 4; l++) {         /* traverse the levels */
+    for (n = i = 0; (f = levels[l][i]) >= 0; i++) {
+      if (FEATGET(c, f)) continue;  /* check the features of the level */
+      if (missing) missing[f >> 5] |= (uint32_t)1 << (f & 31);
+      n++;                          /* collect the missing features */
+    }
+    if (n > 0) break;               /* the level is the highest one */
+  }                                 /* with all features usable */
+  return l;                         /* return the level */
+}  /* cpuinfo_x86level() */
+
+/*----------------------------------------------------------------------------
+Additional info (snapshot):
+  All cpuid leaves that are needed by the query functions are read once
+  on first use and condensed into a packed feature bitmask. Afterwards
+  every has*() query is a plain bit test. cpuid is a serializing
+  instruction and causes a VM exit under most hypervisors, so issuing it
+  on every query is expensive. The snapshot is initialized without locks:
+  the first thread to get here reads the leaves, all others wait for it
+  to publish the result.
+  AVX10 reports a converged version number in leaf 0x24 (EBX[7:0]),
+  which is stored in CPUINFO.avx10ver; the AMX features also need a
+  per-process permission on Linux (without it, the first AMX instruction
+  raises SIGILL). If the permission has not been granted when the
+  snapshot is taken, the AMX features are reported as not usable (but
+  present) until cpuinfo_xstate(CPU_XSTATE_AMX) has requested it; so
+  hasAMXtile() etc. only return 1 if AMX instructions can be executed.
+  A feature that uses wider registers counts as usable only if the OS
+  saves and restores them on context switches: CPUID.1:ECX[27]
+  (OSXSAVE) must be set and XCR0 (read with xgetbv) must enable SSE
+  and YMM state (0x6) for AVX, AVX2 and FMA3, and in addition opmask,
+  ZMM_Hi256 and Hi16_ZMM state (0xe6) for AVX-512. Otherwise the
+  instructions fault with #UD (SIGILL), e.g. in VMs whose hypervisor
+  does not expose these state components. The bits reported by cpuid
+  are kept in CPUINFO.present. The environment variable
+  CPUINFO_FEATURES can mask usable features for A/B tests, e.g.
+  "-avx512f,-avx2" or "-all,+sse2,+sse42" (processed from left to
+  right; '+' only restores detected features, it never forces one).
+  Masking a feature does not mask features that depend on it. If the
+  snapshot is taken by a GNU ifunc resolver (see cpudisp.c) before the
+  C library has set up environ, the variable is read from the initial
+  environment in /proc/self/environ (as is CPUINFO_FILE).
+  cpuinfo_x86level() checks the exact feature sets of the levels of the
+  x86-64 psABI (v2: CMPXCHG16B, LAHF-SAHF, POPCNT, SSE3, SSE4.1/4.2,
+  SSSE3; v3: AVX, AVX2, BMI1/2, F16C, FMA, LZCNT, MOVBE, OSXSAVE; v4:
+  AVX512F/BW/CD/DQ/VL) against the usable features, so that the OS
+  state checks and masks set with CPUINFO_FEATURES are respected. The
+  features missing for the next level are returned as a bitmask that
+  is indexed like CPUINFO.feats (names via cpuinfo_featname()).
+  OSFXSR (CR4.OSFXSR) of v1 cannot be read in user mode; it is implied
+  by a 64-bit OS.
+  gitlab.com/x86-psABIs/x86-64-ABI (sect. 3.1.1, microarch. levels)
+  Intel SDM vol. 2A (CPUID), Intel AVX10 Architecture Specification
+  Intel SDM vol. 1, sect. 13.2 and 14.3; Linux arch/x86/include/uapi/
+  asm/prctl.h and Documentation/arch/x86/xstate.rst (AMX permission)
+----------------------------------------------------------------------------*/
+#if defined __linux__ && defined HAVE_HWLOC
+
+static hwloc_topology_t loadhwloc (void)
+{                                   /* --- load the hwloc topology */
+  hwloc_topology_t h;               /* loaded topology */
+  if (hwloc_topology_init(&h) != 0) return NULL;
+  if (hwloc_topology_load(h)  != 0) {
+    hwloc_topology_destroy(h); return NULL; }
+  return h;                         /* return the loaded topology */
+}  /* loadhwloc() */
 
 /*--------------------------------------------------------------------------*/
 
-void getVendorID (char *buf)
-{                                   /* --- get vendor id */
-  /* the string is going to be exactly 12 characters long, allocate
-     the buffer outside this function accordingly */
-  int eax = 0;
-  int ecx = 0;
-  if ((eax != peax) || (ecx != pecx))
-    cpuid(cpuinfo, eax, ecx);
-  ((unsigned *)buf)[0] = (unsigned)cpuinfo[1]; /* EBX */
-  ((unsigned *)buf)[1] = (unsigned)cpuinfo[3]; /* EDX */
-  ((unsigned *)buf)[2] = (unsigned)cpuinfo[2]; /* ECX */
-}  /* getVendorID() */
+static void delhwloc (void *h)
+{ hwloc_topology_destroy((hwloc_topology_t)h); }
+
+/*--------------------------------------------------------------------------*/
+
+static void inithwloc (void)
+{ ATOMIC_STOREP(&hwtopo, loadhwloc()); }
+
+/*--------------------------------------------------------------------------*/
+
+static int hwcount (hwloc_obj_type_t type)
+{                                   /* --- count hwloc objects */
+  hwloc_topology_t h;               /* shared hwloc topology */
+  int              depth;           /* depth of the object type */
+
+  if (ATOMIC_LOAD(&hwst) != 2) once(&hwst, inithwloc);
+  h = ATOMIC_LOADP(&hwtopo);        /* load the topology (once) */
+  if (!h) return -1;                /* and check for a unique depth */
+  depth = hwloc_get_type_depth(h, type);
+  if (depth < 0) return -1;
+  return (int)hwloc_get_nbobjs_by_depth(h, depth);
+}  /* hwcount() */                  /* return the number of objects */
+
+/*--------------------------------------------------------------------------*/
+
+int corecntHwloc (void)
+{ return hwcount(HWLOC_OBJ_CORE); } /* --- number of processor cores */
+
+#else  /* #if defined __linux__ && defined HAVE_HWLOC */
 
+int corecntHwloc (void)
+{ return -1; }                      /* hwloc is not available */
+
+#endif  /* #if defined __linux__ && defined HAVE_HWLOC .. #else .. */
 /*----------------------------------------------------------------------------
-References (getVendorID):
-  stackoverflow.com/a/3082553
+Additional info and references (corecntHwloc):
+  This function depends on the Portable Hardware Locality (hwloc)
+  software package (define HAVE_HWLOC, as src/makefile does if it finds
+  libhwloc). The hwloc topology is loaded only once, on first use (which
+  takes milliseconds), and is shared by all queries, including the hwloc
+  backend of the counts (see physcnt() etc.). hwloc does not know about
+  CPUINFO_ROOT; it reads a fake root given by HWLOC_FSROOT.
+  stackoverflow.com/a/12486105
+  open-mpi.org/projects/hwloc
 ----------------------------------------------------------------------------*/
-#ifdef CPUINFO_MAIN
 
-int main (int argc, char* argv[])
-{
-  char vendor[12];
-  getVendorID(vendor);
-  printf("Vendor              %s\n", vendor);
-  printf("Physical processors %d\n", physcnt());
-  printf("Processor cores     %d\n", corecnt());
-  printf("Logical processors  %d\n", proccnt());
+static void initbackend (void)
+{                                   /* --- get backend from environment */
+  const char *b = getenv("CPUINFO_BACKEND");
+  int        i;                     /* loop variable */
+
+  backend = BACKEND_DEFAULT;        /* start with the build default */
+  if (!b) return;                   /* and look up the given name */
+  for (i = 0; i < CPU_BACKEND_CNT; i++)
+    if (strcmp(b, backends[i]) == 0) { backend = i; break; }
+}  /* initbackend() */
+
+/*--------------------------------------------------------------------------*/
+
+static int reqbackend (void)
+{                                   /* --- get the requested backend */
+  if (ATOMIC_LOAD(&backst) != 2) once(&backst, initbackend);
+  return backend;                   /* return the backend */
+}  /* reqbackend() */
+
+/*--------------------------------------------------------------------------*/
+
+int cpuinfo_setbackend (int b)
+{                                   /* --- set the backend of the counts */
+  if ((b < 0) || (b >= CPU_BACKEND_CNT)) return -1;
+  #ifndef HAVE_HWLOC                /* check the backend */
+  if (b == CPU_BACKEND_HWLOC) return -1;
+  #endif
+  reqbackend();                     /* make sure the environment */
+  backend = b;                      /* is not read afterwards */
+  cntst   = 0;                      /* set the new backend and */
+  return 0;                         /* recount on next use */
+}  /* cpuinfo_setbackend() */
+
+/*--------------------------------------------------------------------------*/
+
+int cpuinfo_backend (void)
+{                                   /* --- get the backend of the counts */
+  corecnt();                        /* make sure the counts are known */
+  return cntsrc;                    /* return the backend used */
+}  /* cpuinfo_backend() */
+
+/*--------------------------------------------------------------------------*/
+
+const char* cpuinfo_backendname (int b)
+{                                   /* --- get the name of a backend */
+  return ((b >= 0) && (b < CPU_BACKEND_CNT)) ? backends[b] : NULL;
+}  /* cpuinfo_backendname() */
+
+/*----------------------------------------------------------------------------
+Additional info (cpuinfo_setbackend):
+  The counts of physcnt(), corecnt() and proccnt() can be determined by
+  different backends: the sibling lists in sysfs, /proc/cpuinfo, the
+  x2APIC ids of the topology map (cpuid, not with a fake root) and
+  hwloc (if compiled with HAVE_HWLOC). CPU_BACKEND_AUTO tries them in
+  this order. The backend is chosen at build time with the preprocessor
+  definition BACKEND_DEFAULT (e.g. -DBACKEND_DEFAULT=CPU_BACKEND_HWLOC),
+  at runtime with the environment variable CPUINFO_BACKEND (auto, sysfs,
+  proc, cpuid or hwloc), or with cpuinfo_setbackend(), which discards
+  the counts and must not be called while other threads use the module.
+  An explicitly chosen backend that fails yields counts of -1, and
+  cpuinfo_backend() reports CPU_BACKEND_AUTO in this case. If a machine
+  description was imported (see cpuinfo_import()), the counts are taken
+  from it, whatever the backend, and cpuinfo_backend() reports
+  CPU_BACKEND_FILE.
+----------------------------------------------------------------------------*/
+#ifdef __linux__                    /* if Linux system */
+
+static void initroot (void)
+{                                   /* --- get root from environment */
+  const char *r = getenv("CPUINFO_ROOT");
+  if (r && (strlen(r) < sizeof(root))) strcpy(root, r);
+}  /* initroot() */
+
+/*--------------------------------------------------------------------------*/
+
+static const char* getroot (void)
+{                                   /* --- get the root directory */
+  if (ATOMIC_LOAD(&rootst) != 2) once(&rootst, initroot);
+  return root;                      /* return the root directory */
+}  /* getroot() */
+
+/*--------------------------------------------------------------------------*/
+
+static int vreadtxt (char *buf, int size, const char *fmt, va_list args)
+{                                   /* --- read a small text file */
+  char    path[512];                /* path of the file to read */
+  FILE    *fp;                      /* file to read */
+  int     k, n;                     /* length of root, # characters */
+
+  k = (int)strlen(strcpy(path, getroot()));
+  n = vsnprintf(path +k, sizeof(path) -(size_t)k, fmt, args);
+  if ((n < 0) || (n >= (int)sizeof(path) -k)) return -1;
+  fp = fopen(path, "r");            /* open the file and read it */
+  if (!fp) return -1;               /* (only the start of the file) */
+  n = (int)fread(buf, 1, (size_t)size-1, fp);
+  fclose(fp);
+  while ((n > 0) && ((buf[n-1] == '\n') || (buf[n-1] == ' ')))
+    n--;                            /* remove trailing white space */
+  buf[n] = 0;                       /* and terminate the string */
+  return n;                         /* return the number of characters */
+}  /* vreadtxt() */
+
+/*--------------------------------------------------------------------------*/
+
+static int readtxt (char *buf, int size, const char *fmt, ...)
+{                                   /* --- read a small text file */
+  va_list args;                     /* list of variable arguments */
+  int     n;                        /* number of characters read */
+  va_start(args, fmt);              /* format the path of the file */
+  n = vreadtxt(buf, size, fmt, args);
+  va_end(args);                     /* and read the file */
+  return n;                         /* return the number of characters */
+}  /* readtxt() */
+
+/*--------------------------------------------------------------------------*/
+
+static int readint (int *val, const char *fmt, ...)
+{                                   /* --- read an integer from a file */
+  char    buf[64], *e;              /* buffer for the file contents */
+  long    v;                        /* value read from the file */
+  va_list args;                     /* list of variable arguments */
+  int     n;                        /* number of characters read */
+
+  va_start(args, fmt);              /* format the path of the file */
+  n = vreadtxt(buf, sizeof(buf), fmt, args);
+  va_end(args);                     /* and read the file */
+  if (n <= 0) return -1;
+  v = strtol(buf, &e, 0);           /* read the file contents */
+  if ((e == buf) || (*e != 0)) return -1;
+  *val = (int)v;                    /* check for a valid integer */
+  return 0;                         /* and store it */
+}  /* readint() */
+
+/*--------------------------------------------------------------------------*/
+
+static int parselist (const char *s, int *ids, int max)
+{                                   /* --- parse a list like "0-3,8,10" */
+  int  n = 0;                       /* number of ids */
+  long a, b;                        /* range of ids */
+  char *e;                          /* end of a number */
+
+  while (*s) {                      /* traverse the ranges */
+    a = strtol(s, &e, 10);          /* get the start of the range */
+    if ((e == s) || (a < 0)) return -1;
+    b = a; s = e;                   /* get the end of the range */
+    if (*s == '-') {                /* if there is a range, */
+      b = strtol(++s, &e, 10);      /* get the end of the range */
+      if ((e == s) || (b < a)) return -1;
+      s = e;                        /* check for a valid range */
+    }
+    for ( ; a <= b; a++) {          /* store the ids in the range */
+      if (n >= max) return -1;      /* (if there is enough space) */
+      ids[n++] = (int)a;
+    }
+    if      (*s == ',')  s++;       /* skip the separator */
+    else if (*s != 0)   return -1;  /* and check for the end */
+  }
+  return n;                         /* return the number of ids */
+}  /* parselist() */
+
+/*--------------------------------------------------------------------------*/
+
+static int readlist (int **ids, const char *fmt, ...)
+{                                   /* --- read a list of ids */
+  char    *buf;                     /* buffer for the file contents */
+  int     n, max = 8192;            /* number of ids */
+  va_list args;                     /* list of variable arguments */
+
+  buf  = malloc((size_t)max);       /* read the list of ids, */
+  *ids = malloc((size_t)max *sizeof(int)); /* which cannot have more */
+  if (!buf || !*ids) n = -1;        /* than 8192 entries, as they */
+  else {                            /* are separated by commas/dashes */
+    va_start(args, fmt);            /* format the path of the file */
+    n = vreadtxt(buf, max, fmt, args);
+    va_end(args);                   /* read the file */
+    if (n >= 0) n = parselist(buf, *ids, max);
+  }                                 /* and parse the list of ids */
+  free(buf);
+  if (n <= 0) { free(*ids); *ids = NULL; }
+  return n;                         /* return the number of ids */
+}  /* readlist() */
+
+/*--------------------------------------------------------------------------*/
+
+static char* readall (const char *path, size_t *len)
+{                                   /* --- read a whole file */
+  char   *buf, *p;                  /* buffer for the file contents */
+  size_t size = 1 << 16, n = 0;     /* buffer size, bytes read */
+  FILE   *fp;                       /* file to read */
+
+  buf = malloc(strlen(getroot()) +strlen(path) +1);
+  if (!buf) return NULL;            /* open the file */
+  fp = fopen(strcat(strcpy(buf, getroot()), path), "rb");
+  free(buf);
+  if (!fp) return NULL;
+  buf = malloc(size +1);            /* read the file in large blocks */
+  while (buf) {                     /* (procfs files have no size) */
+    n += fread(buf +n, 1, size -n, fp);
+    if (n < size) break;            /* if the buffer is full, */
+    size += size;                   /* enlarge it */
+    p = realloc(buf, size +1);
+    if (!p) free(buf);
+    buf = p;
+  }
+  fclose(fp);                       /* close the file */
+  if (!buf) return NULL;
+  buf[*len = n] = 0;                /* terminate the contents */
+  return buf;                       /* return the file contents */
+}  /* readall() */
+
+/*--------------------------------------------------------------------------*/
+
+static int cmpids (const void *p, const void *q)
+{                                   /* --- compare processor ids */
+  const PROCIDS *a = (PROCIDS*)p;   /* type the given pointers */
+  const PROCIDS *b = (PROCIDS*)q;   /* (PROCIDS array elements) */
+  if (a->phys < b->phys) return -1;
+  if (a->phys > b->phys) return +1;
+  if (a->core < b->core) return -1;
+  if (a->core > b->core) return +1;
+  return 0;                         /* return sign of difference */
+}  /* cmpids() */
+
+/*--------------------------------------------------------------------------*/
+
+static int siblings (const int *ids, int n, const char *file)
+{                                   /* --- count groups of sibling cpus */
+  char *seen;                       /* flags for cpus in a group */
+  int  *sib, i, k, m, max, cnt = 0; /* siblings, loop variables */
+
+  for (max = i = 0; i < n; i++)     /* find the maximum cpu id */
+    if (ids[i] > max) max = ids[i];
+  seen = calloc((size_t)max+1, 1);
+  if (!seen) return -1;             /* create flags for the cpus */
+  for (i = 0; i < n; i++) {         /* traverse the online cpus */
+    if (seen[ids[i]]) continue;     /* skip cpus in a known group */
+    m = readlist(&sib, TOPODIR "%s", ids[i], file);
+    if (m <= 0) { cnt = -1; break; }
+    for (k = 0; k < m; k++)         /* mark the group's cpus */
+      if ((sib[k] >= 0) && (sib[k] <= max)) seen[sib[k]] = 1;
+    free(sib); cnt += 1;            /* one file per group instead */
+  }                                 /* of several files per cpu */
+  free(seen);                       /* delete the flags */
+  return cnt;                       /* return the number of groups */
+}  /* siblings() */
+
+/*--------------------------------------------------------------------------*/
+
+static int cntsysfs (void)
+{                                   /* --- get counts from sysfs */
+  int *ids, n;                      /* online cpus, number of cpus */
+
+  n = readlist(&ids, CPUDIR "online");
+  if (n <= 0) return -1;            /* get the online cpus */
+  nphys  = siblings(ids, n, "core_siblings_list");
+  ncores = siblings(ids, n, "thread_siblings_list");
+  nprocs = n;                       /* count packages and cores */
+  free(ids);                        /* delete the cpu list */
+  return ((nphys > 0) && (ncores > 0)) ? 0 : -1;
+}  /* cntsysfs() */
+
+/*--------------------------------------------------------------------------*/
+
+static int idsproc (PROCIDS **pids)
+{                                   /* --- get ids from /proc/cpuinfo */
+  char    *buf, *s, *e, *end, *c;   /* buffer for the file contents */
+  size_t  len;                      /* length of the file contents */
+  int     n = 0, max = 0;           /* # processors, size of pids */
+  PROCIDS *p;                       /* to enlarge the array */
+
+  buf = readall("/proc/cpuinfo", &len);
+  if (!buf) return -1;              /* read the whole file at once */
+  *pids = NULL;                     /* and traverse its lines */
+  for (s = buf, end = buf +len; s < end; s = e+1) {
+    e = memchr(s, '\n', (size_t)(end -s));
+    if (!e) e = end;                /* find the end of the line */
+    if ((*s != 'p') && (*s != 'c')) continue;
+    c = memchr(s, ':', (size_t)(e -s));
+    if (!c) continue;               /* find the separator */
+    if (strncmp(s, "processor", 9) == 0) {
+      if (n >= max) {               /* if the array is full, */
+        max += (max > 64) ? max : 64;  /* enlarge it */
+        p = realloc(*pids, (size_t)max *sizeof(PROCIDS));
+        if (!p) { n = -1; break; }
+        *pids = p;                  /* start a new processor */
+      }                             /* (missing ids: one package, */
+      (*pids)[n].phys = 0;          /* every processor its own core) */
+      (*pids)[n].core = (int)strtol(c+1, NULL, 10);
+      n++; }
+    else if (n <= 0) continue;      /* skip lines before 1st processor */
+    else if (strncmp(s, "physical id", 11) == 0)
+      (*pids)[n-1].phys = (int)strtol(c+1, NULL, 10);
+    else if (strncmp(s, "core id", 7) == 0)
+      (*pids)[n-1].core = (int)strtol(c+1, NULL, 10);
+  }                                 /* get physical and core id */
+  free(buf);                        /* delete the file contents */
+  if (n <= 0) { free(*pids); *pids = NULL; return -1; }
+  return n;                         /* return the number of processors */
+}  /* idsproc() */
+
+/*--------------------------------------------------------------------------*/
+
+static int cntproc (void)
+{                                   /* --- get counts from /proc/cpuinfo */
+  PROCIDS *pids;                    /* processor ids (physical & core) */
+  int     n, i;                     /* # log. processors, loop variable */
+
+  n = idsproc(&pids);               /* collect physical and core id */
+  if (n <= 0) return -1;            /* of each logical processor */
+  qsort(pids, (size_t)n, sizeof(PROCIDS), cmpids);
+  nphys = ncores = 1;               /* sort the processor ids and */
+  for (i = 1; i < n; i++) {         /* count packages and cores */
+    if      (pids[i].phys != pids[i-1].phys) { nphys += 1; ncores += 1; }
+    else if (pids[i].core != pids[i-1].core)   ncores += 1;
+  }
+  nprocs = n;                       /* note the number of processors */
+  free(pids);                       /* delete the processor ids */
+  return 0;                         /* return 'ok' */
+}  /* cntproc() */
+
+/*--------------------------------------------------------------------------*/
+
+static int cntcpuid (void)
+{                                   /* --- get counts from x2APIC ids */
+  const CPUTOPO *t;                 /* processor topology */
+  if ((cpuinfo_topology(&t) != 0) || !(t->flags & CPUTOPO_CPUID))
+    return -1;                      /* check for cpuid topology ids */
+  nphys  = t->npkgs;                /* (not available with a fake root) */
+  ncores = t->ncores;
+  nprocs = t->nprocs;               /* copy the counts */
+  return 0;                         /* from the topology map */
+}  /* cntcpuid() */
+
+/*--------------------------------------------------------------------------*/
+
+static int cnthwloc (void)
+{                                   /* --- get counts from hwloc */
+  #ifdef HAVE_HWLOC                 /* if hwloc is available */
+  ncores = hwcount(HWLOC_OBJ_CORE);
+  nprocs = hwcount(HWLOC_OBJ_PU);   /* count cores, logical cpus */
+  nphys  = hwcount(HWLOC_OBJ_PACKAGE);  /* and packages */
+  if (nphys <= 0) nphys = 1;        /* (packages may be unknown) */
+  return ((ncores > 0) && (nprocs > 0)) ? 0 : -1;
+  #else                             /* if hwloc is not available */
+  return -1;                        /* the backend always fails */
+  #endif
+}  /* cnthwloc() */
+
+/*--------------------------------------------------------------------------*/
+
+static int cntfile (void)
+{ return -1; }                      /* --- counts are set on import */
+
+/*--------------------------------------------------------------------------*/
+
+static int (*const counters[CPU_BACKEND_CNT])(void) = {
+  NULL, cntsysfs, cntproc, cntcpuid, cnthwloc, cntfile };
+
+/*--------------------------------------------------------------------------*/
+
+static void enumerate (void)
+{                                   /* --- enumerate topology */
+  int b = reqbackend();             /* requested backend */
+
+  if (fromfile()) {                 /* if a description was imported, */
+    cntsrc = CPU_BACKEND_FILE;      /* the counts were read from it */
+    return;
+  }
+
+  /* prefer sysfs (few small files) over /proc/cpuinfo (which has */
+  /* more than 1kB per processor, most of which is not needed) */
+  for (cntsrc = (b != CPU_BACKEND_AUTO) ? b : 1; ; cntsrc++) {
+    if (counters[cntsrc]() == 0) break;
+    if ((b != CPU_BACKEND_AUTO) || (cntsrc >= CPU_BACKEND_CNT-1)) {
+      nphys = ncores = nprocs = -1; /* if no backend yields counts, */
+      cntsrc = CPU_BACKEND_AUTO; return; }    /* abort with failure */
+  }
+  DBGMSG("counts from backend %s\n", backends[cntsrc]);
+  DBGMSG("number of logical processors: %d\n", nprocs);
+  DBGMSG("number of physical processors: %d\n", nphys);
+  DBGMSG("number of cores: %d\n", ncores);
+}  /* enumerate() */
+
+/*--------------------------------------------------------------------------*/
+
+int physcnt (void)
+{                                   /* --- number of physical processors */
+  if (ATOMIC_LOAD(&cntst) != 2) once(&cntst, enumerate);
+  return nphys;
+}  /* physcnt() */
+
+/*--------------------------------------------------------------------------*/
+
+int corecnt (void)
+{                                   /* --- number of processor cores */
+  if (ATOMIC_LOAD(&cntst) != 2) once(&cntst, enumerate);
+  return ncores;
+}  /* corecnt() */
+
+/*--------------------------------------------------------------------------*/
+
+int proccnt (void)
+{                                   /* --- number of logical processors */
+  if (ATOMIC_LOAD(&cntst) != 2) once(&cntst, enumerate);
+  return nprocs;
+}  /* proccnt() */
+
+/*--------------------------------------------------------------------------*/
+#elif defined _WIN32                /* if Microsoft Windows system */
+
+int physcnt (void)
+{                                   /* --- number of physical processors */
+  return -1;                        /* not yet implemented for Windows */
+}  /* physcnt() */
+
+/*--------------------------------------------------------------------------*/
+
+int corecnt (void)
+{                                   /* --- number of processor cores */
+  return -1;                        /* not yet implemented for Windows */
+}  /* corecnt() */
+
+/*--------------------------------------------------------------------------*/
+
+int proccnt (void)
+{                                   /* --- number of logical processors */
+  SYSTEM_INFO sysinfo;              /* system information structure */
+  GetSystemInfo(&sysinfo);          /* get system information */
+  return sysinfo.dwNumberOfProcessors;
+}  /* proccnt() */
+
+/*--------------------------------------------------------------------------*/
+#elif defined __APPLE__             /* if Apple Mac OS system */
+
+int physcnt (void)
+{                                   /* --- number of physical processors */
+  int nphys;
+  size_t len = sizeof(nphys);
+  if (sysctlbyname("hw.packages", &nphys, &len, NULL, (size_t)0))
+    return -1;
+  return nphys;
+}  /* physcnt() */
+
+/*--------------------------------------------------------------------------*/
+
+int corecnt (void)
+{                                   /* --- number of processor cores */
+  int ncores;
+  size_t len = sizeof(ncores);
+  if (sysctlbyname("hw.physicalcpu", &ncores, &len, NULL, (size_t)0))
+    return -1;
+  return ncores;
+}  /* corecnt() */
+
+/*--------------------------------------------------------------------------*/
+
+int proccnt (void)
+{                                   /* --- number of logical processors */
+  int nproc;
+  size_t len = sizeof(nproc);
+  if (sysctlbyname("hw.logicalcpu", &nproc, &len, NULL, (size_t)0))
+    return -1;
+  return nproc;
+}  /* proccnt() */
+
+#endif  /* #ifdef __linux__ .. #elif def. _WIN32 .. #elif def. __APPLE__ .. */
+/*----------------------------------------------------------------------------
+References (proccnt, Windows version):
+  Info on SYSTEM_INFO structure:
+  msdn.microsoft.com/en-us/library/windows/desktop/ms724958%28v=vs.85%29.aspx
+Additional info and references (physcnt/corecnt/proccnt, Linux version):
+  The counts are determined once (thread-safe) from the online cpus and
+  the sibling lists in sysfs (topology/thread_siblings_list for cores,
+  topology/core_siblings_list for packages). A list is read only for a
+  cpu that is not yet covered by an earlier one, so only one small file
+  per core and one per package is read. If sysfs is not available,
+  /proc/cpuinfo is read as a whole and its lines are scanned with memchr
+  (a cpu entry has more than 1kB, most of which is the flags line).
+  Missing ids (e.g. some ARM kernels) count as one package and one core
+  per logical processor. Hybrid processors have more logical processors
+  on some cores than on others, so proccnt() need not be a multiple of
+  corecnt().
+  kernel.org/doc/Documentation/ABI/testing/sysfs-devices-system-cpu
+  kernel.org/doc/html/latest/admin-guide/cputopology.html
+----------------------------------------------------------------------------*/
+
+int proccntmax (void)
+{                                   /* --- max. number of logical processors
+                                     *     per physical processor */
+  return getsnap()->lpmax;          /* EBX[23:16] of leaf 1 */
+}  /* proccntmax() */
+
+/*----------------------------------------------------------------------------
+References (proccntmax):
+  "CPUID.1:EBX[23:16] represents the maximum number of addressable IDs
+  (initial APIC ID) that can be assigned to logical processors in a
+  physical package. The value may not be the same as the number of
+  logical processors that are present in the hardware of a physical package."
+  software.intel.com/en-us/articles/
+    intel-64-architecture-processor-topology-enumeration
+  software.intel.com/sites/default/files/63/1a/
+    Kuo_CpuTopology_rc1.rh1.final.pdf
+----------------------------------------------------------------------------*/
+
+int hasMMX (void)
+{                                   /* --- check for MMX instructions */
+  return (int)FEATGET(getsnap(), CPU_MMX);
+}  /* hasMMX() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasSSE (void)
+{                                   /* --- check for SSE instructions */
+  return (int)FEATGET(getsnap(), CPU_SSE);
+}  /* hasSSE() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasSSE2 (void)
+{                                   /* --- check for SSE2 instructions */
+  return (int)FEATGET(getsnap(), CPU_SSE2);
+}  /* hasSSE2() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasSSE3 (void)
+{                                   /* --- check for SSE3 instructions */
+  return (int)FEATGET(getsnap(), CPU_SSE3);
+}  /* hasSSE3() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasSSSE3 (void)
+{                                   /* --- check for SSSE3 instructions */
+  return (int)FEATGET(getsnap(), CPU_SSSE3);
+}  /* hasSSSE3() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasSSE41 (void)
+{                                   /* --- check for SSE4.1 instructions */
+  return (int)FEATGET(getsnap(), CPU_SSE41);
+}  /* hasSSE41() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasSSE42 (void)
+{                                   /* --- check for SSE4.2 instructions */
+  return (int)FEATGET(getsnap(), CPU_SSE42);
+}  /* hasSSE42() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasPOPCNT (void)
+{                                   /* --- check for popcnt instructions */
+  return (int)FEATGET(getsnap(), CPU_POPCNT);
+}  /* hasPOPCNT() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAVX (void)
+{                                   /* --- check for AVX instructions */
+  return (int)FEATGET(getsnap(), CPU_AVX);
+}  /* hasAVX() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAVX2 (void)
+{                                   /* --- check for AVX2 instructions */
+  return (int)FEATGET(getsnap(), CPU_AVX2);
+}  /* hasAVX2() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasFMA3 (void)
+{                                   /* --- check for FMA3 */
+  return (int)FEATGET(getsnap(), CPU_FMA3);
+}  /* hasFMA3() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAVX512f (void)
+{                                   /* --- check for AVX512f instructions */
+  return (int)FEATGET(getsnap(), CPU_AVX512F);
+}  /* hasAVX512f() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAVX512cd (void)
+{                                   /* --- check for AVX512cd instructions */
+  return (int)FEATGET(getsnap(), CPU_AVX512CD);
+}  /* hasAVX512cd() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAVX512bw (void)
+{                                   /* --- check for AVX512bw instructions */
+  return (int)FEATGET(getsnap(), CPU_AVX512BW);
+}  /* hasAVX512bw() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAVX512dq (void)
+{                                   /* --- check for AVX512dq instructions */
+  return (int)FEATGET(getsnap(), CPU_AVX512DQ);
+}  /* hasAVX512dq() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAVX512vl (void)
+{                                   /* --- check for AVX512vl instructions */
+  return (int)FEATGET(getsnap(), CPU_AVX512VL);
+}  /* hasAVX512vl() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasBMI1 (void)
+{                                   /* --- check for BMI1 instructions */
+  return (int)FEATGET(getsnap(), CPU_BMI1);
+}  /* hasBMI1() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasBMI2 (void)
+{                                   /* --- check for BMI2 instructions */
+  return (int)FEATGET(getsnap(), CPU_BMI2);
+}  /* hasBMI2() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasLZCNT (void)
+{                                   /* --- check for LZCNT instructions */
+  return (int)FEATGET(getsnap(), CPU_LZCNT);
+}  /* hasLZCNT() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasF16C (void)
+{                                   /* --- check for F16C instructions */
+  return (int)FEATGET(getsnap(), CPU_F16C);
+}  /* hasF16C() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasADX (void)
+{                                   /* --- check for ADX instructions */
+  return (int)FEATGET(getsnap(), CPU_ADX);
+}  /* hasADX() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasSHA (void)
+{                                   /* --- check for SHA instructions */
+  return (int)FEATGET(getsnap(), CPU_SHA);
+}  /* hasSHA() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAES (void)
+{                                   /* --- check for AES-NI instructions */
+  return (int)FEATGET(getsnap(), CPU_AES);
+}  /* hasAES() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasVAES (void)
+{                                   /* --- check for VAES instructions */
+  return (int)FEATGET(getsnap(), CPU_VAES);
+}  /* hasVAES() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasVPCLMULQDQ (void)
+{                                   /* --- check for VPCLMULQDQ instructions */
+  return (int)FEATGET(getsnap(), CPU_VPCLMULQDQ);
+}  /* hasVPCLMULQDQ() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasGFNI (void)
+{                                   /* --- check for GFNI instructions */
+  return (int)FEATGET(getsnap(), CPU_GFNI);
+}  /* hasGFNI() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAVX512ifma (void)
+{                                   /* --- check for AVX512ifma instructions */
+  return (int)FEATGET(getsnap(), CPU_AVX512IFMA);
+}  /* hasAVX512ifma() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAVX512vnni (void)
+{                                   /* --- check for AVX512vnni instructions */
+  return (int)FEATGET(getsnap(), CPU_AVX512VNNI);
+}  /* hasAVX512vnni() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAVX512bf16 (void)
+{                                   /* --- check for AVX512bf16 instructions */
+  return (int)FEATGET(getsnap(), CPU_AVX512BF16);
+}  /* hasAVX512bf16() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAVX512fp16 (void)
+{                                   /* --- check for AVX512fp16 instructions */
+  return (int)FEATGET(getsnap(), CPU_AVX512FP16);
+}  /* hasAVX512fp16() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAVX512vbmi (void)
+{                                   /* --- check for AVX512vbmi instructions */
+  return (int)FEATGET(getsnap(), CPU_AVX512VBMI);
+}  /* hasAVX512vbmi() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAVX512vbmi2 (void)
+{                                   /* --- check for AVX512vbmi2 */
+  return (int)FEATGET(getsnap(), CPU_AVX512VBMI2);
+}  /* hasAVX512vbmi2() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAVX512bitalg (void)
+{                                   /* --- check for AVX512bitalg */
+  return (int)FEATGET(getsnap(), CPU_AVX512BITALG);
+}  /* hasAVX512bitalg() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAVX512vpopcntdq (void)
+{                                   /* --- check for AVX512vpopcntdq */
+  return (int)FEATGET(getsnap(), CPU_AVX512VPOPCNTDQ);
+}  /* hasAVX512vpopcntdq() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAVXvnni (void)
+{                                   /* --- check for AVX-VNNI instructions */
+  return (int)FEATGET(getsnap(), CPU_AVXVNNI);
+}  /* hasAVXvnni() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAVX10 (void)
+{                                   /* --- check for AVX10 instructions */
+  return (int)FEATGET(getsnap(), CPU_AVX10);
+}  /* hasAVX10() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAMXtile (void)
+{                                   /* --- check for AMX-TILE instructions */
+  return (int)FEATGET(getsnap(), CPU_AMXTILE);
+}  /* hasAMXtile() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAMXint8 (void)
+{                                   /* --- check for AMX-INT8 instructions */
+  return (int)FEATGET(getsnap(), CPU_AMXINT8);
+}  /* hasAMXint8() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasAMXbf16 (void)
+{                                   /* --- check for AMX-BF16 instructions */
+  return (int)FEATGET(getsnap(), CPU_AMXBF16);
+}  /* hasAMXbf16() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasMOVDIRI (void)
+{                                   /* --- check for MOVDIRI instructions */
+  return (int)FEATGET(getsnap(), CPU_MOVDIRI);
+}  /* hasMOVDIRI() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasSERIALIZE (void)
+{                                   /* --- check for SERIALIZE instructions */
+  return (int)FEATGET(getsnap(), CPU_SERIALIZE);
+}  /* hasSERIALIZE() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasFPU (void)
+{                                   /* --- check for x87 FPU */
+  return (int)FEATGET(getsnap(), CPU_FPU);
+}  /* hasFPU() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasCX8 (void)
+{                                   /* --- check for CMPXCHG8B */
+  return (int)FEATGET(getsnap(), CPU_CX8);
+}  /* hasCX8() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasCMOV (void)
+{                                   /* --- check for CMOV */
+  return (int)FEATGET(getsnap(), CPU_CMOV);
+}  /* hasCMOV() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasFXSR (void)
+{                                   /* --- check for FXSAVE/FXRSTOR */
+  return (int)FEATGET(getsnap(), CPU_FXSR);
+}  /* hasFXSR() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasSYSCALL (void)
+{                                   /* --- check for SYSCALL/SYSRET */
+  return (int)FEATGET(getsnap(), CPU_SYSCALL);
+}  /* hasSYSCALL() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasCX16 (void)
+{                                   /* --- check for CMPXCHG16B */
+  return (int)FEATGET(getsnap(), CPU_CX16);
+}  /* hasCX16() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasLAHF (void)
+{                                   /* --- check for LAHF/SAHF (64-bit) */
+  return (int)FEATGET(getsnap(), CPU_LAHF);
+}  /* hasLAHF() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasMOVBE (void)
+{                                   /* --- check for MOVBE */
+  return (int)FEATGET(getsnap(), CPU_MOVBE);
+}  /* hasMOVBE() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasOSXSAVE (void)
+{                                   /* --- check for OS support of XSAVE */
+  return (int)FEATGET(getsnap(), CPU_OSXSAVE);
+}  /* hasOSXSAVE() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasRDTSCP (void)
+{                                   /* --- check for RDTSCP */
+  return (int)FEATGET(getsnap(), CPU_RDTSCP);
+}  /* hasRDTSCP() */
+
+/*--------------------------------------------------------------------------*/
+
+int hasRDPID (void)
+{                                   /* --- check for RDPID */
+  return (int)FEATGET(getsnap(), CPU_RDPID);
+}  /* hasRDPID() */
+
+/*--------------------------------------------------------------------------*/
+
+void getVendorID (char *buf)
+{                                   /* --- get vendor id */
+  /* the string is going to be exactly 12 characters long, allocate
+     the buffer outside this function accordingly */
+  memcpy(buf, getsnap()->vendor, 12);
+}  /* getVendorID() */
+
+/*----------------------------------------------------------------------------
+References (getVendorID):
+  stackoverflow.com/a/3082553
+----------------------------------------------------------------------------*/
+#ifdef __linux__                    /* if Linux system */
+#if defined __x86_64__ || defined __i386__
+
+static int amdext (void)
+{                                   /* --- check for AMD topology ext. */
+  int32_t info[4];                  /* result of a cpuid call */
+  if (getsnap()->maxext < (int)0x8000001e) return 0;
+  cpuid(info, (int32_t)0x80000001, 0);
+  return (info[ECX] >> 22) & 1;     /* TopologyExtensions bit */
+}  /* amdext() */
+
+/*--------------------------------------------------------------------------*/
+
+static void extids (RAWIDS *r)
+{                                   /* --- decode the ext. APIC id (AMD) */
+  int32_t info[4];                  /* result of a cpuid call */
+  int     smt, pkg, n;              /* shifts for the levels, counter */
+
+  cpuid(info, (int32_t)0x80000008, 0);
+  pkg = (info[ECX] >> 12) & 0xf;    /* get the ApicIdSize */
+  if (pkg == 0) {                   /* legacy: derive it from the */
+    n = (info[ECX] & 0xff) +1;      /* number of threads per package */
+    for (pkg = 0; (1 << pkg) < n; pkg++); }
+  cpuid(info, (int32_t)0x8000001e, 0);
+  r->apic = info[EAX];              /* get the extended APIC id */
+  n = ((info[EBX] >> 8) & 0xff) +1; /* and the threads per core */
+  for (smt = 0; (1 << smt) < n; smt++);
+  r->xpkg  = r->apic >> pkg;        /* compute the package, die, */
+  r->xdie  = info[ECX] & 0xff;      /* and core ids (the node id */
+  r->xcore = r->apic >> smt;        /* identifies the die) */
+}  /* extids() */
+
+/*--------------------------------------------------------------------------*/
+
+static void apicids (RAWIDS *r, int hybrid, int ext)
+{                                   /* --- decode the x2APIC id */
+  int32_t info[4];                  /* result of a cpuid call */
+  int     leaf, i, type, shift;     /* leaf, subleaf, level type, shift */
+  int     smt = 0, die = -1, pkg = 0;  /* shifts for the levels */
+
+  leaf = (getsnap()->maxleaf >= 0x1f) ? 0x1f : 0x0b;
+  info[EBX] = 0;                    /* (leaf 0x0b may be missing) */
+  if (getsnap()->maxleaf >= 0x0b)   /* prefer the v2 extended topology */
+    cpuid(info, leaf, 0);           /* leaf (0x1f), which also knows */
+  if ((leaf == 0x1f) && !info[EBX]) /* about dies, to leaf 0x0b */
+    cpuid(info, leaf = 0x0b, 0);
+  if (!info[EBX]) {                 /* if there is no valid leaf, */
+    if (ext) extids(r);             /* fall back to the AMD topology */
+    return;                         /* extensions (leaf 0x8000001e) */
+  }
+  r->apic = info[EDX];              /* get the x2APIC id */
+  for (i = 0; i < 8; i++) {         /* traverse the levels */
+    cpuid(info, leaf, i);
+    type  = (info[ECX] >> 8) & 0xff;/* get the level type and the */
+    shift =  info[EAX] & 0x1f;      /* shift to the next level */
+    if (type == 0) break;           /* check for the last level */
+    if (type == 1) smt = shift;     /* SMT level */
+    if (type <  5) die = shift;     /* SMT/core/module/tile level */
+    pkg = shift;                    /* (the die is above the tile) */
+  }
+  if (die < 0) die = pkg;           /* if there is no die level */
+  r->xpkg  = r->apic >> pkg;        /* compute the package, die, */
+  r->xdie  = r->apic >> die;        /* and core ids from the shifts */
+  r->xcore = r->apic >> smt;
+  if (!hybrid) return;              /* on a hybrid processor get */
+  cpuid(info, 0x1a, 0);             /* the native model id/core type */
+  r->xtype = (info[EAX] >> 24) & 0xff;
+}  /* apicids() */
+
+/*--------------------------------------------------------------------------*/
+
+static int cpuidall (RAWIDS *raw, int n)
+{                                   /* --- run cpuid on all cpus */
+  cpu_set_t prev, cur;              /* previous and current affinity */
+  int32_t   info[4];                /* result of a cpuid call */
+  int       i, k = 0, hybrid, ext;  /* loop variable, counter, flags */
+
+  ext = amdext();                   /* check for a topology leaf */
+  if ((getsnap()->maxleaf < 0x0b) && !ext) return 0;
+  cpuid(info, 7, 0);                /* check for a hybrid processor */
+  hybrid = (getsnap()->maxleaf >= 0x1a) && ((info[EDX] >> 15) & 1);
+  if (sched_getaffinity(0, sizeof(prev), &prev)) return 0;
+  for (i = 0; i < n; i++) {         /* traverse the logical cpus */
+    if (raw[i].cpu >= CPU_SETSIZE) continue;
+    CPU_ZERO(&cur); CPU_SET((size_t)raw[i].cpu, &cur);
+    if (sched_setaffinity(0, sizeof(cur), &cur)) continue;
+    apicids(raw +i, hybrid, ext);   /* move to the cpu and decode */
+    if (raw[i].apic >= 0) k++;      /* its x2APIC id */
+  }                                 /* (cpus outside of the cpuset */
+  sched_setaffinity(0, sizeof(prev), &prev);  /* cannot be reached) */
+  return k;                         /* return the number of cpus */
+}  /* cpuidall() */
+
+#else  /* #if defined __x86_64__ || defined __i386__ */
+
+static int cpuidall (RAWIDS *raw, int n)
+{ return 0; }                       /* no cpuid on other architectures */
+
+#endif  /* #if defined __x86_64__ || defined __i386__ .. #else .. */
+/*--------------------------------------------------------------------------*/
+
+static int sysfsall (RAWIDS *raw, int n)
+{                                   /* --- read ids from sysfs */
+  int i, k = 0;                     /* loop variable, counter */
+
+  for (i = 0; i < n; i++) {         /* traverse the logical cpus */
+    if (readint(&raw[i].spkg,  TOPODIR "physical_package_id", raw[i].cpu)
+    ||  readint(&raw[i].score, TOPODIR "core_id", raw[i].cpu))
+      continue;                     /* read package and core id */
+    if (readint(&raw[i].sdie,  TOPODIR "die_id",  raw[i].cpu))
+      raw[i].sdie = 0;              /* die ids need Linux 5.x */
+    k++;                            /* count the cpus with ids */
+  }
+  return k;                         /* return the number of cpus */
+}  /* sysfsall() */
+
+/*--------------------------------------------------------------------------*/
+
+static int agree (const RAWIDS *raw, int n)
+{                                   /* --- compare cpuid and sysfs ids */
+  int i, k;                         /* loop variables */
+  for (i = 0; i < n; i++) {         /* the two sources agree if they */
+    for (k = i+1; k < n; k++) {     /* induce the same partitions */
+      if ((raw[i].xpkg == raw[k].xpkg) != (raw[i].spkg == raw[k].spkg))
+        return 0;                   /* into packages */
+      if (((raw[i].xpkg  == raw[k].xpkg)
+      &&   (raw[i].xcore == raw[k].xcore))
+      !=  ((raw[i].spkg  == raw[k].spkg)  && (raw[i].sdie == raw[k].sdie)
+      &&   (raw[i].score == raw[k].score)))
+        return 0;                   /* and into cores */
+    }
+  }
+  return 1;                         /* the ids agree */
+}  /* agree() */
+
+/*--------------------------------------------------------------------------*/
+
+static int inlist (const int *ids, int n, int cpu)
+{                                   /* --- check whether cpu is in list */
+  while (--n >= 0) if (ids[n] == cpu) return 1;
+  return 0;                         /* (lists are short, so a linear */
+}  /* inlist() */                   /* search is sufficient) */
+
+/*--------------------------------------------------------------------------*/
+
+static int captypes (RAWIDS *raw, int n)
+{                                   /* --- get core types and capacities */
+  int *core, *atom;                 /* cpus of the core/atom PMUs */
+  int nc, na, i, k, max = 0;        /* list sizes, loop variables */
+  int ncap = 0, nfrq = 0, ntyped = 0;  /* counters for the sources */
+  int mixed = 0;                    /* whether types/capacities differ */
+
+  nc = readlist(&core, "/sys/devices/cpu_core/cpus");
+  na = readlist(&atom, "/sys/devices/cpu_atom/cpus");
+  for (i = 0; i < n; i++) {         /* traverse the logical cpus */
+    k = raw[i].cpu;                 /* prefer the perf. event PMUs */
+    if      ((nc > 0) && inlist(core, nc, k)) raw[i].type = CPU_CORE_PERF;
+    else if ((na > 0) && inlist(atom, na, k)) raw[i].type = CPU_CORE_EFF;
+    else if (raw[i].xtype == 0x40)            raw[i].type = CPU_CORE_PERF;
+    else if (raw[i].xtype == 0x20)            raw[i].type = CPU_CORE_EFF;
+    else                                      raw[i].type = CPU_CORE_ANY;
+    if (raw[i].type != CPU_CORE_ANY) ntyped++;
+    if (readint(&raw[i].cap, CPUDIR "cpu%d/cpu_capacity", k) == 0)
+      ncap++;                       /* get the capacity from the kernel */
+  }
+  if (nc > 0) free(core);           /* delete the cpu lists */
+  if (na > 0) free(atom);
+  if ((ncap < n) && (ntyped >= n)) {/* if typed, but no capacities, */
+    for (i = 0; i < n; i++)         /* use the maximum frequencies */
+      if (readint(&raw[i].cap, CPUDIR "cpu%d/cpufreq/cpuinfo_max_freq",
+                  raw[i].cpu) == 0) nfrq++;
+  }                                 /* (not for all cpus: AMD preferred */
+  if ((ncap < n) && (nfrq < n))     /* cores only differ in frequency) */
+    for (i = 0; i < n; i++) raw[i].cap = CPU_CAPACITY_MAX;
+  for (i = 0; i < n; i++)           /* find the maximum capacity */
+    if (raw[i].cap > max) max = raw[i].cap;
+  for (i = 0; i < n; i++) {         /* scale the capacities */
+    raw[i].cap = (int)(((int64_t)raw[i].cap *CPU_CAPACITY_MAX +max/2)/max);
+    if (raw[i].cap < 1) raw[i].cap = 1;
+    if ((raw[i].cap != raw[0].cap) || (raw[i].type != raw[0].type))
+      mixed = 1;                    /* check for different cpus */
+  }
+  if (!mixed) {                     /* if all cpus are equal, */
+    for (i = 0; i < n; i++)         /* there is only one core type */
+      raw[i].type = CPU_CORE_ANY;
+    return 0;
+  }
+  for (i = 0; i < n; i++)           /* derive missing core types */
+    if (raw[i].type == CPU_CORE_ANY)/* from the capacities */
+      raw[i].type = (raw[i].cap >= CPU_CAPACITY_MAX)
+                  ? CPU_CORE_PERF : CPU_CORE_EFF;
+  return CPUTOPO_HYBRID;            /* return the hybrid flag */
+}  /* captypes() */
+
+/*--------------------------------------------------------------------------*/
+
+static int cmpraw (const void *p, const void *q)
+{                                   /* --- compare raw ids */
+  const RAWIDS *a = (RAWIDS*)p;     /* type the given pointers */
+  const RAWIDS *b = (RAWIDS*)q;     /* (RAWIDS array elements) */
+  if (a->pkg  < b->pkg)  return -1;
+  if (a->pkg  > b->pkg)  return +1;
+  if (a->die  < b->die)  return -1;
+  if (a->die  > b->die)  return +1;
+  if (a->core < b->core) return -1;
+  if (a->core > b->core) return +1;
+  return (a->cpu > b->cpu) - (a->cpu < b->cpu);
+}  /* cmpraw() */
+
+/*--------------------------------------------------------------------------*/
+
+static CPUTOPO* maketopo (RAWIDS *raw, int n, int flags)
+{                                   /* --- build topology from raw ids */
+  CPUTOPO *t;                       /* created topology */
+  CPULOC  *l;                       /* location of current cpu */
+  int     i, k, ncpus;              /* loop variables, # entries */
+
+  qsort(raw, (size_t)n, sizeof(RAWIDS), cmpraw);
+  for (ncpus = i = 0; i < n; i++)   /* sort the ids and determine */
+    if (raw[i].cpu >= ncpus) ncpus = raw[i].cpu +1;  /* the max. cpu */
+  t = malloc(sizeof(CPUTOPO) +(size_t)ncpus *sizeof(CPULOC)
+                             +(size_t)(2*n+1)*sizeof(int));
+  if (!t) return NULL;              /* allocate the topology */
+  t->cpus     = (CPULOC*)(t+1);     /* in a single memory block */
+  t->coreoff  = (int*)(t->cpus +ncpus);
+  t->corecpus = t->coreoff +n+1;
+  t->ncpus    = ncpus;              /* initialize the counters */
+  t->nprocs   = n;
+  t->npkgs    = t->ndies = t->ncores = 0;
+  t->flags    = flags;
+  for (i = 0; i < CPU_CORE_TYPES; i++) t->ntype[i] = 0;
+  for (i = 0; i < ncpus; i++) {     /* mark all cpus as offline */
+    l = t->cpus +i; l->apic = -1;
+    l->pkg = l->die = l->core = l->smt = -1;
+    l->type = CPU_CORE_ANY; l->capacity = 0; }
+  for (i = k = 0; i < n; i++) {     /* traverse the sorted ids */
+    if ((i == 0) || (raw[i].pkg != raw[i-1].pkg)) {
+      t->npkgs++;  t->ndies++;  t->coreoff[t->ncores++] = i; k = 0; }
+    else if (raw[i].die  != raw[i-1].die) {
+      t->ndies++;               t->coreoff[t->ncores++] = i; k = 0; }
+    else if (raw[i].core != raw[i-1].core) {
+                                t->coreoff[t->ncores++] = i; k = 0; }
+    l = t->cpus +raw[i].cpu;        /* count packages, dies and cores */
+    l->apic = raw[i].apic;          /* and store the dense indices */
+    l->pkg  = t->npkgs  -1;         /* of the logical cpu */
+    l->die  = t->ndies  -1;
+    l->core = t->ncores -1;
+    l->smt  = k++;                  /* the SMT index is the rank */
+    l->type = raw[i].type;          /* within the core */
+    l->capacity = raw[i].cap;
+    if (l->smt == 0) t->ntype[l->type]++;
+    t->corecpus[i] = raw[i].cpu;    /* count the cores per type */
+  }
+  t->coreoff[t->ncores] = n;        /* store the sentinel */
+  return t;                         /* return the created topology */
+}  /* maketopo() */
+
+/*--------------------------------------------------------------------------*/
+
+static CPUTOPO* loadtopo (void)
+{                                   /* --- load the processor topology */
+  RAWIDS  *raw;                     /* raw ids of the logical cpus */
+  int     *ids;                     /* numbers of the online cpus */
+  int     i, n, nx, ns, flags = 0;  /* loop variable, counters, flags */
+  CPUTOPO *t;                       /* created topology */
+
+  n = readlist(&ids, CPUDIR "online");
+  if (n <= 0) return NULL;          /* get the online cpus */
+  raw = malloc((size_t)n *sizeof(RAWIDS));
+  if (!raw) { free(ids); return NULL; }
+  for (i = 0; i < n; i++) {         /* initialize the raw ids */
+    raw[i].cpu  = ids[i];    raw[i].apic = -1;
+    raw[i].xpkg = raw[i].xdie = raw[i].xcore = -1;
+    raw[i].spkg = raw[i].sdie = raw[i].score = -1;
+    raw[i].xtype = raw[i].type = raw[i].cap = 0;
+  }
+  free(ids);
+  nx = (*getroot()) ? 0            /* get the ids from cpuid, */
+     : cpuidall(raw, n);            /* unless a fake root is used */
+  ns = sysfsall(raw, n);            /* and from sysfs */
+  if (nx >= n) flags |= CPUTOPO_CPUID;
+  if (ns >= n) flags |= CPUTOPO_SYSFS;
+  if ((flags & CPUTOPO_CPUID) && (flags & CPUTOPO_SYSFS) && agree(raw, n))
+    flags |= CPUTOPO_AGREE;         /* cross-check the two sources */
+  if (flags & CPUTOPO_SYSFS) {      /* prefer the ids from sysfs */
+    for (i = 0; i < n; i++) {       /* (the kernel knows about quirks) */
+      raw[i].pkg = raw[i].spkg; raw[i].die = raw[i].sdie;
+      raw[i].core = raw[i].score; } }
+  else if (flags & CPUTOPO_CPUID) { /* fall back to the x2APIC ids */
+    for (i = 0; i < n; i++) {
+      raw[i].pkg = raw[i].xpkg; raw[i].die = raw[i].xdie;
+      raw[i].core = raw[i].xcore; } }
+  else {                            /* if no ids are available, */
+    for (i = 0; i < n; i++) {       /* treat all cpus as separate */
+      raw[i].pkg = 0; raw[i].die = 0; raw[i].core = raw[i].cpu; } }
+  if ((flags & CPUTOPO_CPUID) && (flags & CPUTOPO_SYSFS)
+  &&  !(flags & CPUTOPO_AGREE))
+    DBGMSG("cpuid and sysfs topologies differ, using sysfs\n");
+  flags |= captypes(raw, n);        /* get core types and capacities */
+  t = maketopo(raw, n, flags);      /* build the topology */
+  free(raw);                        /* delete the raw ids */
+  return t;                         /* return the created topology */
+}  /* loadtopo() */
+
+#else  /* #ifdef __linux__ */
+
+static CPUTOPO* loadtopo (void)
+{ return NULL; }                    /* not yet implemented */
+
+#endif  /* #ifdef __linux__ .. #else .. */
+/*--------------------------------------------------------------------------*/
+
+static void inittopo (void)
+{                                   /* --- load the topology */
+  if (!fromfile()) ATOMIC_STOREP(&topo, loadtopo());
+}  /* inittopo() */
+
+/*--------------------------------------------------------------------------*/
+
+int cpuinfo_topology (const CPUTOPO **map)
+{                                   /* --- get the processor topology */
+  if (ATOMIC_LOAD(&topost) != 2) once(&topost, inittopo);
+  *map = ATOMIC_LOADP(&topo);       /* return the topology */
+  return (*map) ? 0 : -1;           /* and whether it is available */
+}  /* cpuinfo_topology() */
+
+/*----------------------------------------------------------------------------
+Additional info and references (cpuinfo_topology):
+  The x2APIC id of each logical cpu is obtained by running cpuid on it
+  (temporarily restricting the affinity of the calling thread) and is
+  split into package, die, core and SMT fields with the shifts reported
+  by the extended topology leaves 0x1f (v2, with die level) or 0x0b.
+  AMD processors without these leaves report the extended APIC id, the
+  threads per core and the node (die) id in leaf 0x8000001e, and the
+  width of the core field (ApicIdSize) in leaf 0x80000008.
+  The result is cross-checked against the ids that the kernel reports in
+  /sys/devices/system/cpu/cpu<n>/topology, which take precedence if the
+  two disagree. All ids are renumbered densely (in order of package,
+  die and core), so that they can be used directly as array indices;
+  the logical cpus of core c are corecpus[coreoff[c] .. coreoff[c+1]-1].
+  On hybrid processors (Alder Lake and later, ARM big.LITTLE) the core
+  type is taken from the cpu lists of the perf. event PMUs cpu_core and
+  cpu_atom, or else from cpuid leaf 0x1a (EAX[31:24]: 0x40 = Core,
+  0x20 = Atom). The relative capacity of a cpu is the kernel's
+  cpu_capacity (scale 1024), or, if that is missing but core types are
+  known, the ratio of the maximum frequencies (which underestimates the
+  difference, as Atom cores also have a lower IPC). On homogeneous
+  processors all cpus have type CPU_CORE_ANY and capacity 1024.
+  kernel.org/doc/Documentation/ABI/testing/sysfs-devices-system-cpu
+  (cpu_capacity), Intel SDM vol. 2A, CPUID leaf 1AH
+  software.intel.com/en-us/articles/
+    intel-64-architecture-processor-topology-enumeration
+  kernel.org/doc/Documentation/admin-guide/cputopology.rst
+----------------------------------------------------------------------------*/
+#ifdef __linux__                    /* if Linux system */
+#if defined __x86_64__ || defined __i386__
+
+static int cpuidcaches (CPUCACHE *c, int max)
+{                                   /* --- get caches from cpuid */
+  const CPUINFO *ci = getsnap();    /* processor feature snapshot */
+  int32_t info[4];                  /* result of a cpuid call */
+  int     i, leaf, parts;           /* loop variable, leaf, partitions */
+
+  cpuid(info, (int32_t)0x80000001, 0);
+  if      (strcmp(ci->vendor, "GenuineIntel") == 0 && ci->maxleaf >= 4)
+    leaf = 4;                       /* Intel: deterministic cache */
+  else if ((ci->maxext >= (int)0x8000001d) && (info[ECX] & (1 << 22)))
+    leaf = (int)0x8000001d;         /* AMD: cache topology leaf */
+  else return 0;                    /* (needs topology extensions) */
+  for (i = 0; i < max; i++) {       /* traverse the subleaves */
+    cpuid(info, leaf, i);           /* get the next cache */
+    if ((info[EAX] & 0x1f) == 0) break;
+    c[i].type  =  info[EAX]       & 0x1f;   /* 1: data, 2: instruction, */
+    c[i].level = (info[EAX] >> 5) & 0x07;   /* 3: unified */
+    c[i].line  = (info[EBX]        & 0xfff) +1;
+    parts      = (info[EBX] >> 12) & 0x3ff;
+    c[i].ways  = ((info[EBX] >> 22) & 0x3ff) +1;
+    c[i].sets  = info[ECX] +1;
+    c[i].size  = c[i].ways *(parts+1) *c[i].line *c[i].sets;
+    if (info[EAX] & (1 << 9)) c[i].ways = 0;  /* fully associative */
+    c[i].inclusive = (info[EDX] >> 1) & 1;
+    c[i].nshare    = ((info[EAX] >> 14) & 0xfff) +1;
+  }                                 /* (max. # sharing logical cpus) */
+  return i;                         /* return the number of caches */
+}  /* cpuidcaches() */
+
+#else  /* #if defined __x86_64__ || defined __i386__ */
+
+static int cpuidcaches (CPUCACHE *c, int max)
+{ return 0; }                       /* no cpuid on other architectures */
+
+#endif  /* #if defined __x86_64__ || defined __i386__ .. #else .. */
+/*--------------------------------------------------------------------------*/
+
+static int sysfscaches (CPUCACHE *c, int max, int cpu)
+{                                   /* --- get caches from sysfs */
+  char buf[64], *e;                 /* buffer for file contents */
+  int  i, n = 0;                    /* loop variable, number of caches */
+  long v;                           /* size of the cache */
+
+  for (i = 0; n < max; i++) {       /* traverse the cache indices */
+    if (readint(&c[n].level, CACHEDIR "level", cpu, i)) break;
+    if (readtxt(buf, sizeof(buf), CACHEDIR "type", cpu, i) <= 0) break;
+    c[n].type = (buf[0] == 'D') ? CPUCACHE_DATA
+              : (buf[0] == 'I') ? CPUCACHE_INSTR : CPUCACHE_UNIFIED;
+    if (readtxt(buf, sizeof(buf), CACHEDIR "size", cpu, i) <= 0) break;
+    v = strtol(buf, &e, 10);        /* parse the cache size */
+    if      (*e == 'K') v <<= 10;   /* (with unit K or M) */
+    else if (*e == 'M') v <<= 20;
+    c[n].size = (int)v;
+    if (readint(&c[n].line, CACHEDIR "coherency_line_size", cpu, i)
+    ||  readint(&c[n].ways, CACHEDIR "ways_of_associativity", cpu, i)
+    ||  readint(&c[n].sets, CACHEDIR "number_of_sets", cpu, i))
+      c[n].line = c[n].ways = c[n].sets = -1;
+    c[n].inclusive = -1;            /* inclusivity is not reported */
+    c[n].nshare    = 0;             /* and sharing is found later */
+    c[n].index     = i; n++;        /* note the sysfs index */
+  }
+  return n;                         /* return the number of caches */
+}  /* sysfscaches() */
+
+/*--------------------------------------------------------------------------*/
+
+static int sharing (CPUCACHE *c, const CPUTOPO *t, int *key)
+{                                   /* --- determine sharing sets */
+  int i, k, n, *ids;                /* loop variables, buffer */
+  int shift;                        /* shift for the x2APIC ids */
+
+  for (i = 0; i < t->ncpus; i++) key[i] = -1;
+  if (c->index >= 0) {              /* if the cache is known in sysfs */
+    for (i = 0; i < t->ncpus; i++) {/* traverse the online cpus */
+      if ((t->cpus[i].pkg < 0) || (key[i] >= 0)) continue;
+      n = readlist(&ids, CACHEDIR "shared_cpu_list", i, c->index);
+      if (n <= 0) break;            /* read the cpus sharing the cache */
+      for (k = 0; k < n; k++)       /* and use the current cpu */
+        if ((ids[k] < t->ncpus) && (t->cpus[ids[k]].pkg >= 0))
+          key[ids[k]] = i;          /* as the key of the instance */
+      free(ids);
+    }
+    if (i >= t->ncpus) return 0;    /* if all lists were read, abort */
+  }
+  if (t->flags & CPUTOPO_CPUID) {   /* if the x2APIC ids are known */
+    for (shift = 0; (1 << shift) < c->nshare; shift++);
+    for (i = 0; i < t->ncpus; i++)  /* the instance is given by the */
+      if (t->cpus[i].pkg >= 0)      /* x2APIC id without the lower bits */
+        key[i] = t->cpus[i].apic >> shift;
+    return 0;
+  }
+  for (i = 0; i < t->ncpus; i++)    /* as a last resort, assume that */
+    if (t->cpus[i].pkg >= 0)        /* L1/L2 are per core, L3 per pkg. */
+      key[i] = (c->level >= 3) ? t->cpus[i].pkg : t->cpus[i].core;
+  return 0;                         /* return 'ok' */
+}  /* sharing() */
+
+/*--------------------------------------------------------------------------*/
+
+static int instances (CPUCACHE *c, const CPUTOPO *t, const int *key)
+{                                   /* --- build the instance arrays */
+  int i, k, n;                      /* loop variables, counter */
+
+  c->inst = malloc((size_t)(t->ncpus +2*t->nprocs +1) *sizeof(int));
+  if (!c->inst) return -1;          /* allocate the arrays */
+  c->instoff  = c->inst    +t->ncpus;
+  c->instcpus = c->instoff +t->nprocs +1;
+  for (i = 0; i < t->ncpus; i++)    /* renumber the instance keys */
+    c->inst[i] = -1;                /* densely (in order of the */
+  for (c->ninst = i = 0; i < t->ncpus; i++) {   /* first logical cpu) */
+    if ((key[i] < 0) || (c->inst[i] >= 0)) continue;
+    for (k = i; k < t->ncpus; k++)  /* assign the next instance index */
+      if (key[k] == key[i]) c->inst[k] = c->ninst;
+    c->ninst++;                     /* to all cpus with the same key */
+  }
+  for (c->nshare = n = k = 0; k < c->ninst; k++) {
+    c->instoff[k] = n;              /* collect the cpus per instance */
+    for (i = 0; i < t->ncpus; i++)
+      if (c->inst[i] == k) c->instcpus[n++] = i;
+    if (n -c->instoff[k] > c->nshare) c->nshare = n -c->instoff[k];
+  }                                 /* determine the max. # of cpus */
+  c->instoff[c->ninst] = n;         /* sharing an instance */
+  return 0;                         /* return 'ok' */
+}  /* instances() */
+
+/*--------------------------------------------------------------------------*/
+
+static CACHETAB* loadcaches (const CPUTOPO *t)
+{                                   /* --- load the cache descriptions */
+  CACHETAB *tab;                    /* table of caches */
+  CPUCACHE c[CACHEMAX], s[CACHEMAX];/* cpuid and sysfs caches */
+  int      i, k, n, m, *key;        /* loop variables, counters, keys */
+
+  for (i = 0; i < t->ncpus; i++)    /* get the topology and */
+    if (t->cpus[i].pkg >= 0) break; /* find the first online cpu */
+  m = sysfscaches(s, CACHEMAX, i);  /* get the caches from sysfs */
+  n = (*getroot()) ? 0              /* and from cpuid (preferred), */
+    : cpuidcaches(c, CACHEMAX);     /* unless a fake root is used */
+  for (i = 0; i < n; i++) {         /* traverse the cpuid caches */
+    c[i].index = -1;                /* find the sysfs index */
+    for (k = 0; k < m; k++)         /* of the same cache */
+      if ((s[k].level == c[i].level) && (s[k].type == c[i].type)) {
+        c[i].index = s[k].index; break; }
+  }
+  if (n <= 0) { memcpy(c, s, sizeof(c)); n = m; }
+  if (n <= 0) return NULL;          /* fall back to the sysfs caches */
+  tab = malloc(sizeof(CACHETAB) +(size_t)n *sizeof(CPUCACHE));
+  key = malloc((size_t)t->ncpus *sizeof(int));
+  if (!tab || !key) { free(tab); free(key); return NULL; }
+  tab->c = (CPUCACHE*)(tab+1);      /* allocate the table and keys */
+  for (i = 0; i < n; i++) {         /* traverse the caches */
+    tab->c[i] = c[i];               /* copy the description and */
+    sharing(tab->c +i, t, key);     /* determine the sharing sets */
+    if (instances(tab->c +i, t, key) != 0) break;
+  }
+  free(key);                        /* delete the instance keys */
+  tab->n = i;                       /* note the number of caches */
+  if (i < n) { delcaches(tab); return NULL; }
+  return tab;                       /* return the table of caches */
+}  /* loadcaches() */
+
+#else  /* #ifdef __linux__ */
+
+static CACHETAB* loadcaches (const CPUTOPO *t)
+{ return NULL; }                    /* not yet implemented */
+
+#endif  /* #ifdef __linux__ .. #else .. */
+/*--------------------------------------------------------------------------*/
+
+static void initcaches (void)
+{                                   /* --- load the cache descriptions */
+  const CPUTOPO *t;                 /* processor topology */
+  if (!fromfile() && (cpuinfo_topology(&t) == 0))
+    ATOMIC_STOREP(&caches, loadcaches(t));
+}  /* initcaches() */
+
+/*--------------------------------------------------------------------------*/
+
+int cpuinfo_caches (const CPUCACHE **cs)
+{                                   /* --- get the cache descriptions */
+  const CACHETAB *c;                /* table of caches */
+  if (ATOMIC_LOAD(&cachest) != 2) once(&cachest, initcaches);
+  c = ATOMIC_LOADP(&caches);        /* get the table of caches */
+  *cs = (c) ? c->c : NULL;          /* return the descriptions */
+  return (c) ? c->n : 0;            /* and their number */
+}  /* cpuinfo_caches() */
+
+/*--------------------------------------------------------------------------*/
+
+const CPUCACHE* cpuinfo_cache (int level, int type)
+{                                   /* --- find a cache */
+  const CPUCACHE *c;                /* cache descriptions */
+  int i, n;                         /* loop variable, number of caches */
+
+  n = cpuinfo_caches(&c);           /* get the cache descriptions */
+  for (i = 0; i < n; i++)           /* and find the requested one */
+    if ((c[i].level == level) && ((c[i].type == type)
+    ||  ((c[i].type == CPUCACHE_UNIFIED) && (type != CPUCACHE_UNIFIED))))
+      return c +i;                  /* (a unified cache can serve as */
+  return NULL;                      /* a data or instruction cache) */
+}  /* cpuinfo_cache() */
+
+/*--------------------------------------------------------------------------*/
+
+int cachesize (int level)
+{                                   /* --- size of a data cache */
+  const CPUCACHE *c = cpuinfo_cache(level, CPUCACHE_DATA);
+  return (c) ? c->size : -1;        /* return the size in bytes */
+}  /* cachesize() */
+
+/*--------------------------------------------------------------------------*/
+
+int cacheline (void)
+{                                   /* --- line size of the L1 cache */
+  const CPUCACHE *c = cpuinfo_cache(1, CPUCACHE_DATA);
+  return (c && (c->line > 0)) ? c->line : -1;
+}  /* cacheline() */
+
+/*--------------------------------------------------------------------------*/
+
+int l3cnt (void)
+{                                   /* --- number of L3 cache domains */
+  const CPUCACHE *c = cpuinfo_cache(3, CPUCACHE_DATA);
+  return (c) ? c->ninst : -1;       /* return the number of instances */
+}  /* l3cnt() */
+
+/*--------------------------------------------------------------------------*/
+
+int cpuinfo_cpul3 (int cpu)
+{                                   /* --- get the L3 domain of a cpu */
+  const CPUTOPO  *t;                /* processor topology */
+  const CPUCACHE *c;                /* L3 cache description */
+  if (!(c = cpuinfo_cache(3, CPUCACHE_DATA))
+  ||  (cpuinfo_topology(&t) != 0) || (cpu < 0) || (cpu >= t->ncpus))
+    return -1;                      /* check the cpu number */
+  return c->inst[cpu];              /* return the instance index */
+}  /* cpuinfo_cpul3() */
+
+/*--------------------------------------------------------------------------*/
+
+int cpuinfo_l3set (int dom, CPUSET *set)
+{                                   /* --- get the cpus of an L3 domain */
+  const CPUCACHE *c;                /* L3 cache description */
+  int i, n = 0;                     /* loop variable, number of cpus */
+
+  memset(set, 0, sizeof(CPUSET));   /* clear the cpu set */
+  c = cpuinfo_cache(3, CPUCACHE_DATA);
+  if (!c || (dom < 0) || (dom >= c->ninst)) return -1;
+  for (i = c->instoff[dom]; i < c->instoff[dom+1]; i++)
+    if (c->instcpus[i] < CPUSET_MAX) {
+      CPUSET_SET(set, c->instcpus[i]); n++; }
+  return n;                         /* return the number of cpus */
+}  /* cpuinfo_l3set() */
+
+/*----------------------------------------------------------------------------
+Additional info and references (cpuinfo_caches):
+  The cache parameters are read from cpuid leaf 4 (Intel) or 0x8000001d
+  (AMD, if topology extensions are supported) and otherwise from
+  /sys/devices/system/cpu/cpu<n>/cache/index<i>. The sets of logical
+  cpus sharing a cache instance are taken from the shared_cpu_list files
+  in sysfs, which reflect disabled cores, and otherwise derived from the
+  x2APIC ids and the max. number of sharing cpus reported by cpuid.
+  The logical cpus of instance k are instcpus[instoff[k] .. instoff[k+1]-1].
+  Note that cpuid reports the caches of the cpu it runs on, which matters
+  on hybrid processors with different core types.
+  The instances of the L3 cache are the L3 domains: on AMD processors
+  each CCX (core complex; one per CCD since Zen 3) has its own L3 slice,
+  so a package consists of several domains, and traffic between them is
+  much more expensive than within one. l3cnt() returns the number of
+  domains, cpuinfo_cpul3() the domain of a logical cpu, and
+  cpuinfo_l3set() the cpus of a domain (e.g. for cpuinfo_pin(), to keep
+  cooperating threads inside one domain). On AMD the sharing is derived
+  from cpuid leaf 0x8000001d (NumSharingCache) and the extended APIC ids
+  of leaf 0x8000001e unless sysfs reports it.
+  software.intel.com/content/www/us/en/develop/articles/
+    intel-sdm.html (Vol. 2A, CPUID leaf 04H)
+  AMD64 Architecture Programmer's Manual, Vol. 3 (CPUID Fn8000_001D)
+  kernel.org/doc/Documentation/ABI/testing/sysfs-devices-system-cpu
+----------------------------------------------------------------------------*/
+#ifdef __linux__                    /* if Linux system */
+
+static int64_t meminfo (const char *text, const char *field)
+{                                   /* --- get a field of a meminfo file */
+  const char *p = strstr(text, field);
+  if (!p) return -1;                /* find the field and return */
+  return (int64_t)strtoll(p +strlen(field), NULL, 10) << 10;
+}  /* meminfo() */                  /* its value (given in kB) */
+
+/*--------------------------------------------------------------------------*/
+
+static CPUNUMA* loadnuma (const CPUTOPO *t)
+{                                   /* --- load the NUMA node topology */
+  CPUNUMA *m;                       /* created NUMA node topology */
+  CPUNODE *d;                       /* to traverse the nodes */
+  int     *ids, *cpus;              /* node ids, cpus of a node */
+  int     i, k, n, c;               /* loop variables, counters */
+  char    *buf, *s, *e;             /* buffer for file contents */
+  long    v;                        /* distance between nodes */
+
+  n = readlist(&ids, NODEDIR "online");
+  if (n <= 0) {                     /* if there are no nodes in sysfs, */
+    n = 1; ids = malloc(sizeof(int));  /* (kernel without NUMA) */
+    if (!ids) return NULL;          /* treat the system as one node */
+    ids[0] = -1;                    /* (id -1 means "not in sysfs") */
+  }
+  buf  = malloc(4096);              /* allocate the buffers */
+  m    = (buf) ? malloc(sizeof(CPUNUMA) +(size_t)n *sizeof(CPUNODE)
+                  +(size_t)(n*n +2*t->ncpus +n+1) *sizeof(int)) : NULL;
+  if (!m) { free(ids); free(buf); return NULL; }
+  m->nnodes  = n;                   /* organize the memory block */
+  m->nodes   = (CPUNODE*)(m+1);
+  m->dist    = (int*)(m->nodes +n);
+  m->ncpus   = t->ncpus;
+  m->cpunode  = m->dist    +n*n;
+  m->nodeoff  = m->cpunode +t->ncpus;
+  m->nodecpus = m->nodeoff +n+1;
+  for (i = 0; i < t->ncpus; i++) m->cpunode[i] = -1;
+  for (i = 0; i < n; i++) {         /* traverse the nodes */
+    d = m->nodes +i; d->id = ids[i];
+    for (k = 0; k < n; k++)         /* initialize the distances */
+      m->dist[i*n+k] = (i == k) ? 10 : 20;
+    d->memtotal = d->memfree = -1;  /* and the node description */
+    d->ncpus = 0;
+    if (ids[i] < 0) {               /* if there is no node in sysfs, */
+      d->memtotal = (int64_t)sysconf(_SC_PHYS_PAGES)
+                  * (int64_t)sysconf(_SC_PAGESIZE);
+      for (c = 0; c < t->ncpus; c++)/* the node has all memory */
+        if (t->cpus[c].pkg >= 0) m->cpunode[c] = i;
+      continue;                     /* and all online cpus */
+    }
+    k = readlist(&cpus, NODEDIR "node%d/cpulist", ids[i]);
+    for (c = 0; c < k; c++)         /* read the cpus of the node */
+      if ((cpus[c] < t->ncpus) && (t->cpus[cpus[c]].pkg >= 0))
+        m->cpunode[cpus[c]] = i;    /* and map them to the node */
+    free(cpus);
+    if (readtxt(buf, 4096, NODEDIR "node%d/meminfo", ids[i]) > 0) {
+      d->memtotal = meminfo(buf, "MemTotal:");
+      d->memfree  = meminfo(buf, "MemFree:");
+    }                               /* read the memory of the node */
+    if (readtxt(buf, 4096, NODEDIR "node%d/distance", ids[i]) > 0) {
+      for (s = buf, k = 0; k < n; k++) {
+        v = strtol(s, &e, 10);      /* read the SLIT distances */
+        if (e == s) break;          /* to the other online nodes */
+        m->dist[i*n+k] = (int)v; s = e;
+      }
+    }
+  }
+  free(buf); free(ids);             /* delete the buffers */
+  for (k = i = 0; i < n; i++) {     /* collect the cpus per node */
+    m->nodeoff[i] = k;
+    for (c = 0; c < t->ncpus; c++)
+      if (m->cpunode[c] == i) m->nodecpus[k++] = c;
+    m->nodes[i].ncpus = k -m->nodeoff[i];
+  }
+  m->nodeoff[n] = k;                /* store the sentinel */
+  return m;                         /* return the NUMA topology */
+}  /* loadnuma() */
+
+#else  /* #ifdef __linux__ */
+
+static CPUNUMA* loadnuma (const CPUTOPO *t)
+{ return NULL; }                    /* not yet implemented */
+
+#endif  /* #ifdef __linux__ .. #else .. */
+/*--------------------------------------------------------------------------*/
+
+static void initnuma (void)
+{                                   /* --- load the NUMA topology */
+  const CPUTOPO *t;                 /* processor topology */
+  if (!fromfile() && (cpuinfo_topology(&t) == 0))
+    ATOMIC_STOREP(&numa, loadnuma(t));
+}  /* initnuma() */
+
+/*--------------------------------------------------------------------------*/
+
+int cpuinfo_numa (const CPUNUMA **map)
+{                                   /* --- get the NUMA node topology */
+  if (ATOMIC_LOAD(&numast) != 2) once(&numast, initnuma);
+  *map = ATOMIC_LOADP(&numa);       /* return the NUMA topology */
+  return (*map) ? 0 : -1;           /* and whether it is available */
+}  /* cpuinfo_numa() */
+
+/*--------------------------------------------------------------------------*/
+
+int cpuinfo_cpunode (int cpu)
+{                                   /* --- get the node of a cpu */
+  const CPUNUMA *m;                 /* NUMA node topology */
+  if ((cpuinfo_numa(&m) != 0) || (cpu < 0) || (cpu >= m->ncpus))
+    return -1;                      /* check the cpu number */
+  return m->cpunode[cpu];           /* return the node index */
+}  /* cpuinfo_cpunode() */
+
+/*--------------------------------------------------------------------------*/
+
+int nodecnt (void)
+{                                   /* --- number of NUMA nodes */
+  const CPUNUMA *m;                 /* NUMA node topology */
+  return (cpuinfo_numa(&m) == 0) ? m->nnodes : -1;
+}  /* nodecnt() */
+
+/*----------------------------------------------------------------------------
+Additional info and references (cpuinfo_numa):
+  The nodes, their cpus and memory and the SLIT distances between them
+  are read from /sys/devices/system/node, so that libnuma is not needed.
+  Sockets and NUMA nodes need not coincide: with sub-NUMA clustering or
+  NPS settings a package is split into several nodes, and there may be
+  nodes without cpus (memory-only nodes, e.g. CXL or HBM). The nodes are
+  indexed densely; CPUNODE.id is the node number used by the kernel
+  (e.g. for mbind() or numactl). The distance of node i to node k is
+  dist[i*nnodes+k], normalized to 10 for local accesses. The logical
+  cpus of node i are nodecpus[nodeoff[i] .. nodeoff[i+1]-1].
+  kernel.org/doc/Documentation/ABI/stable/sysfs-devices-node
+----------------------------------------------------------------------------*/
+#ifdef __linux__                    /* if Linux system */
+
+static int affinity (CPUSET *set)
+{                                   /* --- get the affinity mask */
+  cpu_set_t cs;                     /* affinity mask of this thread */
+  char      *buf, *s;               /* buffer for /proc/self/status */
+  int       i, n, *ids;             /* loop variable, number of ids */
+
+  memset(set, 0, sizeof(CPUSET));   /* clear the cpu set */
+  if (!*getroot()) {                /* if the real system is used */
+    if (sched_getaffinity(0, sizeof(cs), &cs)) return -1;
+    for (i = 0; (i < CPU_SETSIZE) && (i < CPUSET_MAX); i++)
+      if (CPU_ISSET((size_t)i, &cs)) CPUSET_SET(set, i);
+    return 0;                       /* copy the affinity mask */
+  }                                 /* to the cpu set */
+  buf = malloc(16384);              /* for a fake root, read the */
+  if (!buf) return -1;              /* allowed cpus from the status */
+  n = readtxt(buf, 16384, "/proc/self/status");
+  s = (n > 0) ? strstr(buf, "Cpus_allowed_list:") : NULL;
+  ids = (s) ? malloc(8192 *sizeof(int)) : NULL;
+  if (!ids) { free(buf); return -1; }
+  s += strlen("Cpus_allowed_list:");
+  while ((*s == ' ') || (*s == '\t')) s++;
+  s[strcspn(s, "\n")] = 0;          /* get the list of allowed cpus */
+  n = parselist(s, ids, 8192);      /* and parse it */
+  for (i = 0; i < n; i++)           /* copy the ids to the cpu set */
+    if (ids[i] < CPUSET_MAX) CPUSET_SET(set, ids[i]);
+  free(ids); free(buf);             /* delete the buffers */
+  return (n > 0) ? 0 : -1;          /* return the error status */
+}  /* affinity() */
+
+/*--------------------------------------------------------------------------*/
+
+static int readfd (int *fd, const char *path, char *buf, int size)
+{                                   /* --- read a file kept open */
+  char name[512];                   /* path of the file to read */
+  long n;                           /* number of characters read */
+
+  if (*fd < 0) {                    /* if the file is not open */
+    n = snprintf(name, sizeof(name), "%s%s", getroot(), path);
+    if ((n < 0) || (n >= (long)sizeof(name))) return -1;
+    *fd = open(name, O_RDONLY|O_CLOEXEC);
+    if (*fd < 0) return -1;         /* open the file */
+  }                                 /* (sysfs, procfs and cgroupfs */
+  n = (long)pread(*fd, buf, (size_t)size-1, 0);  /* regenerate the */
+  if (n < 0) { close(*fd); *fd = -1; return -1; }  /* contents on */
+  while ((n > 0) && ((buf[n-1] == '\n') || (buf[n-1] == ' ')))
+    n--;                            /* every read at offset 0, which */
+  buf[n] = 0;                       /* is much cheaper than opening */
+  return (int)n;                    /* the file again; remove white */
+}  /* readfd() */                   /* space as vreadtxt() does) */
+
+/*--------------------------------------------------------------------------*/
+
+static void closefds (void)
+{                                   /* --- close the watched files */
+  int i;                            /* loop variable */
+  for (i = 0; i < nwatch; i++) {    /* traverse the watched files */
+    if (watchfd[i] >= 0) close(watchfd[i]);
+    watchfd[i] = -1;                /* close the files, but */
+  }                                 /* keep their names */
+  if (onlfd >= 0) close(onlfd);     /* close the online cpus */
+  onlfd    = -1;                    /* and note the process */
+  watchpid = (long)getpid();        /* (descriptors of /proc/self */
+}  /* closefds() */                 /* must be reopened after fork()) */
+
+/*--------------------------------------------------------------------------*/
+
+static void watchfile (const char *fmt, ...)
+{                                   /* --- note a file to watch */
+  va_list args;                     /* list of variable arguments */
+  int     i, n;                     /* loop variable, path length */
+
+  if ((nwatch < 0) || (nwatch >= WATCHMAX)) {
+    nwatch = -1; return; }          /* (-1: too many files to watch) */
+  va_start(args, fmt);              /* format the path of the file */
+  n = vsnprintf(watch[nwatch], sizeof(watch[0]), fmt, args);
+  va_end(args);                     /* (a path that is too long */
+  if ((n < 0) || (n >= (int)sizeof(watch[0]))) {  /* cannot be */
+    nwatch = -1; return; }          /* watched, so give up) */
+  for (i = 0; i < nwatch; i++)      /* check whether the file */
+    if (strcmp(watch[i], watch[nwatch]) == 0) return;
+  watchfd[nwatch++] = -1;           /* is already watched, */
+}  /* watchfile() */                /* otherwise add it */
+
+/*--------------------------------------------------------------------------*/
+
+static uint64_t fnv (uint64_t h, const void *p, size_t n)
+{                                   /* --- FNV-1a hash of a memory block */
+  const unsigned char *s = p;       /* to traverse the bytes */
+  while (n-- > 0) h = (h ^ *s++) *0x100000001b3ULL;
+  return h;                         /* return the new hash value */
+}  /* fnv() */
+
+/*--------------------------------------------------------------------------*/
+
+static uint64_t effhash (void)
+{                                   /* --- hash the inputs of geteff() */
+  CPUSET   set;                     /* affinity mask */
+  char     buf[1024];               /* buffer for the file contents */
+  uint64_t h = FNVINIT;             /* hash value */
+  int      i, n;                    /* loop variable, file size */
+
+  if ((long)getpid() != watchpid) closefds();
+  n = affinity(&set);               /* hash the affinity mask */
+  h = fnv(h, &n, sizeof(n));
+  if (n == 0) h = fnv(h, &set, sizeof(set));
+  for (i = 0; i < nwatch; i++) {    /* hash the watched files */
+    n = readfd(watchfd +i, watch[i], buf, sizeof(buf));
+    if (n >= (int)sizeof(buf)-1) return 0;
+    h = fnv(h, &n, sizeof(n));      /* (the size distinguishes */
+    if (n > 0) h = fnv(h, buf, (size_t)n);
+  }                                 /* missing and empty files) */
+  return h | 1;                     /* return the hash value */
+}  /* effhash() */                  /* (0: unknown, file too long) */
+
+/*--------------------------------------------------------------------------*/
+
+static int cgpath (char *path, int size, const char *ctrl)
+{                                   /* --- get the cgroup of a controller */
+  char *buf, *s, *e, *c, *p;        /* buffer for /proc/self/cgroup */
+  int  k, n, r = -1;                /* lengths of controller names */
+
+  buf = malloc(8192);               /* read the cgroup memberships */
+  if (!buf) return -1;              /* (lines "id:controllers:path") */
+  watchfile("/proc/self/cgroup");   /* (the process may be moved) */
+  if (readtxt(buf, 8192, "/proc/self/cgroup") <= 0) { free(buf); return -1; }
+  n = (int)strlen(ctrl);            /* get the length of the name */
+  for (s = buf; *s; s = (*e) ? e+1 : e) {
+    e = s +strcspn(s, "\n");        /* traverse the lines */
+    c = memchr(s, ':', (size_t)(e-s));
+    if (!c) continue;               /* find the controller list */
+    c++;                            /* skip the hierarchy id */
+    p = memchr(c, ':', (size_t)(e-c));
+    if (!p) continue;               /* find the path */
+    if (n <= 0) {                   /* cgroup v2: empty controller list */
+      if (p > c) continue; }
+    else {                          /* cgroup v1: find the controller */
+      for ( ; c < p; c += k+1) {    /* in the comma-separated list */
+        k = (int)strcspn(c, ",:");
+        if ((k == n) && (strncmp(c, ctrl, (size_t)n) == 0)) break;
+      }
+      if (c >= p) continue;         /* skip other hierarchies */
+    }
+    if (e -p > size) continue;      /* check the length of the path */
+    memcpy(path, p+1, (size_t)(e-p-1));
+    path[e-p-1] = 0; r = 0; break;  /* copy the cgroup path */
+  }
+  free(buf);                        /* delete the buffer */
+  if ((r == 0) && (strcmp(path, "/") == 0)) *path = 0;
+  return r;                         /* return the error status */
+}  /* cgpath() */
+
+/*--------------------------------------------------------------------------*/
+
+static double quota (void)
+{                                   /* --- get the cpu quota (cgroups) */
+  static const char *v1dirs[] = {   /* cgroup v1 mount points */
+    "/sys/fs/cgroup/cpu,cpuacct", "/sys/fs/cgroup/cpu" };
+  char   path[256], buf[64], *e;    /* cgroup path, file contents */
+  double q, min = -1;               /* current and min. quota */
+  long   a, b;                      /* quota and period */
+  int    i;                         /* loop variable */
+
+  if (cgpath(path, sizeof(path), "") == 0) {
+    while (1) {                     /* cgroup v2: traverse the path */
+      watchfile("/sys/fs/cgroup%s/cpu.max", path);
+      if (readtxt(buf, sizeof(buf), "/sys/fs/cgroup%s/cpu.max", path) > 0
+      &&  (strncmp(buf, "max", 3) != 0)) {
+        a = strtol(buf, &e, 10);    /* read "quota period" */
+        b = strtol(e,   NULL, 10);  /* (or "max period") */
+        if ((a > 0) && (b > 0)) { q = (double)a/(double)b;
+          if ((min < 0) || (q < min)) min = q; }
+      }                             /* keep the smallest quota */
+      if (!*path) break;            /* go to the parent cgroup */
+      *strrchr(path, '/') = 0;      /* (quotas of ancestors also apply) */
+    }
+  }
+  if (cgpath(path, sizeof(path), "cpu") != 0) return min;
+  for (i = 0; i < 2; i++) {         /* cgroup v1: find the mount point */
+    if (readtxt(buf, sizeof(buf), "%s/cpu.cfs_period_us", v1dirs[i]) > 0)
+      break;                        /* (check the root of the hierarchy) */
+  }
+  if (i >= 2) return min;           /* if no v1 hierarchy is mounted */
+  while (1) {                       /* traverse the path */
+    watchfile("%s%s/cpu.cfs_quota_us",  v1dirs[i], path);
+    watchfile("%s%s/cpu.cfs_period_us", v1dirs[i], path);
+    if ((readtxt(buf, sizeof(buf), "%s%s/cpu.cfs_quota_us",
+                 v1dirs[i], path) > 0)
+    &&  ((a = strtol(buf, NULL, 10)) > 0)
+    &&  (readtxt(buf, sizeof(buf), "%s%s/cpu.cfs_period_us",
+                 v1dirs[i], path) > 0)
+    &&  ((b = strtol(buf, NULL, 10)) > 0)) {
+      q = (double)a/(double)b;      /* compute the quota */
+      if ((min < 0) || (q < min)) min = q;
+    }                               /* keep the smallest quota */
+    if (!*path) break;              /* go to the parent cgroup */
+    *strrchr(path, '/') = 0;
+  }
+  return min;                       /* return the smallest quota */
+}  /* quota() */
+
+/*--------------------------------------------------------------------------*/
+
+static void cpusets (CPUSET *set)
+{                                   /* --- restrict to cgroup cpuset */
+  char path[256];                   /* cgroup path */
+  int  i, n, *ids = NULL;           /* loop variable, list of cpus */
+  CPUSET cs;                        /* cpus in the cpuset */
+
+  if      (cgpath(path, sizeof(path), "") == 0) {
+    watchfile("/sys/fs/cgroup%s/cpuset.cpus.effective", path);
+    n = readlist(&ids, "/sys/fs/cgroup%s/cpuset.cpus.effective", path); }
+  else if (cgpath(path, sizeof(path), "cpuset") == 0) {
+    watchfile("/sys/fs/cgroup/cpuset%s/cpuset.effective_cpus", path);
+    watchfile("/sys/fs/cgroup/cpuset%s/cpuset.cpus", path);
+    n = readlist(&ids, "/sys/fs/cgroup/cpuset%s/cpuset.effective_cpus",path);
+    if (n <= 0)                     /* cgroup v1 has effective_cpus */
+      n = readlist(&ids, "/sys/fs/cgroup/cpuset%s/cpuset.cpus", path);
+  }                                 /* only with cgroup v2 semantics */
+  else return;                      /* read the cpus of the cpuset */
+  if (n <= 0) return;               /* (the kernel already restricts */
+  memset(&cs, 0, sizeof(cs));       /* the affinity mask accordingly, */
+  for (i = 0; i < n; i++)           /* but fake roots may not) */
+    if (ids[i] < CPUSET_MAX) CPUSET_SET(&cs, ids[i]);
+  free(ids);                        /* intersect the cpu set */
+  for (i = 0; i < CPUSET_MAX/64; i++) set->bits[i] &= cs.bits[i];
+}  /* cpusets() */
+
+/*--------------------------------------------------------------------------*/
+
+static void geteff (CPUEFF *e)
+{                                   /* --- compute effective resources */
+  const CPUTOPO *t;                 /* processor topology */
+  int           i, n;               /* loop variable, limit */
+  uint64_t      s;                  /* signature of the inputs */
+
+  s = (nwatch > 0) ? effhash() : 0; /* hash the inputs (old files) */
+  closefds(); nwatch = 0; effsig = 0;   /* collect the files anew */
+  memset(e, 0, sizeof(CPUEFF));     /* clear the result */
+  e->quota = -1;                    /* and get the topology */
+  if (cpuinfo_topology(&t) != 0) return;
+  if (affinity(&e->allowed) != 0)   /* get the affinity mask */
+    for (i = 0; (i < t->ncpus) && (i < CPUSET_MAX); i++)
+      CPUSET_SET(&e->allowed, i);   /* (all cpus if it is unknown) */
+  cpusets(&e->allowed);             /* restrict it to the cpuset */
+  for (i = 0; i < CPUSET_MAX; i++) {/* and to the online cpus */
+    if (!CPUSET_ISSET(&e->allowed, i)) continue;
+    if ((i >= t->ncpus) || (t->cpus[i].pkg < 0)) {
+      CPUSET_CLR(&e->allowed, i); continue; }
+    e->nallowed++;                  /* count the allowed cpus */
+    if (t->cpus[i].core >= CPUSET_MAX) continue;
+    if (!CPUSET_ISSET(&e->cores, t->cpus[i].core)) {
+      CPUSET_SET(&e->cores, t->cpus[i].core); e->ncores++; }
+  }                                 /* collect the cores they belong to */
+  e->quota  = quota();              /* get the cpu quota */
+  e->nprocs = e->nallowed; e->ncoreseff = e->ncores;
+  if (e->quota > 0) {               /* if there is a quota, */
+    n = (int)e->quota;              /* round it up to whole cpus */
+    if ((double)n < e->quota) n++;  /* and use it as a limit */
+    if (e->nprocs    > n) e->nprocs    = n;
+    if (e->ncoreseff > n) e->ncoreseff = n;
+  }                                 /* keep the signature only if */
+  if ((nwatch > 0) && (effhash() == s))  /* the inputs did not change */
+    effsig = s;                     /* while they were read */
+}  /* geteff() */
+
+/*--------------------------------------------------------------------------*/
+
+static int effchg (void)
+{                                   /* --- check the inputs of geteff() */
+  return (effsig == 0) || (effhash() != effsig);
+}  /* effchg() */
+
+#else  /* #ifdef __linux__ */
+
+static void geteff (CPUEFF *e)
+{                                   /* --- compute effective resources */
+  memset(e, 0, sizeof(CPUEFF));     /* not yet implemented */
+  e->quota = -1;
+}  /* geteff() */
+
+/*--------------------------------------------------------------------------*/
+
+static int effchg (void)
+{ return 1; }                       /* --- inputs are not watched */
+
+#endif  /* #ifdef __linux__ .. #else .. */
+/*--------------------------------------------------------------------------*/
+
+static CPUEFF* loadeff (void)
+{                                   /* --- compute effective resources */
+  CPUEFF *e = malloc(sizeof(CPUEFF));
+  if (e) geteff(e);                 /* allocate and compute */
+  return e;                         /* the effective resources */
+}  /* loadeff() */
+
+/*--------------------------------------------------------------------------*/
+
+static void initeff (void)
+{                                   /* --- compute effective resources */
+  if (!fromfile()) ATOMIC_STOREP(&eff, loadeff());
+}  /* initeff() */
+
+/*--------------------------------------------------------------------------*/
+
+int cpuinfo_effective (const CPUEFF **e)
+{                                   /* --- get effective cpu resources */
+  const CPUEFF *p;                  /* effective cpu resources */
+  if (ATOMIC_LOAD(&effst) != 2) once(&effst, initeff);
+  p  = ATOMIC_LOADP(&eff);          /* get the effective resources */
+  *e = (p) ? p : &effnone;          /* and return them */
+  return (p && (p->nallowed > 0)) ? 0 : -1;
+}  /* cpuinfo_effective() */
+
+/*--------------------------------------------------------------------------*/
+
+int proccnt_effective (void)
+{                                   /* --- effective # logical procs. */
+  const CPUEFF *e;                  /* effective cpu resources */
+  return (cpuinfo_effective(&e) == 0) ? e->nprocs : proccnt();
+}  /* proccnt_effective() */
+
+/*--------------------------------------------------------------------------*/
+
+int corecnt_effective (void)
+{                                   /* --- effective # processor cores */
+  const CPUEFF *e;                  /* effective cpu resources */
+  return (cpuinfo_effective(&e) == 0) ? e->ncoreseff : corecnt();
+}  /* corecnt_effective() */
+
+/*--------------------------------------------------------------------------*/
+
+int cpuset_count (const CPUSET *set)
+{                                   /* --- count the cpus in a cpu set */
+  int i, n = 0;                     /* loop variable, counter */
+  for (i = 0; i < CPUSET_MAX; i++) n += (int)CPUSET_ISSET(set, i);
+  return n;                         /* return the number of cpus */
+}  /* cpuset_count() */
+
+/*--------------------------------------------------------------------------*/
+
+static CURTAB* loadcur (void)
+{                                   /* --- build the cpu location table */
+  const CPUTOPO *t;                 /* processor topology */
+  CURTAB        *tab;               /* table of cpu locations */
+  CPUCUR        *c;                 /* to traverse the table */
+  int           i, n;               /* loop variable, number of cpus */
+
+  if (cpuinfo_topology(&t) != 0) t = NULL;
+  n = (t) ? t->ncpus : CPUSET_MAX;  /* get the number of cpus */
+  tab = malloc(sizeof(CURTAB) +(size_t)n *sizeof(CPUCUR));
+  if (!tab) return NULL;            /* allocate the table */
+  tab->c = (CPUCUR*)(tab+1); tab->n = n;
+  for (i = 0; i < n; i++) {         /* fill the table */
+    c = tab->c +i; *c = curnone; c->cpu = i;
+    if (!t || (i >= t->ncpus) || (t->cpus[i].pkg < 0)) continue;
+    c->core = t->cpus[i].core;      /* copy the indices */
+    c->pkg  = t->cpus[i].pkg;       /* from the topology */
+    c->node = cpuinfo_cpunode(i);   /* and look up the node */
+    c->l3   = cpuinfo_cpul3(i);     /* and the L3 domain */
+  }
+  return tab;                       /* return the created table */
+}  /* loadcur() */
+
+/*--------------------------------------------------------------------------*/
+
+static void reset (void)
+{                                   /* --- discard all loaded data */
+  if (caches) delcaches(caches);    /* delete the loaded objects */
+  caches = NULL;                    /* and reset their states */
+  free(numa);   numa   = NULL;
+  free(topo);   topo   = NULL;
+  free(eff);    eff    = NULL;
+  cachest = numast = topost = effst = cntst = 0;
+  filest  = fileok = 0;             /* (re-import a description file) */
+  #if defined __linux__ && defined HAVE_HWLOC
+  if (hwtopo) hwloc_topology_destroy(hwtopo);
+  hwtopo = NULL; hwst = 0;          /* discard the hwloc topology */
+  #endif
+  nphys = ncores = nprocs = 0;      /* clear the counts */
+  free(curtab); curtab = NULL;      /* delete the table of */
+  curst = 0;                        /* current cpu locations */
+  free(mem); mem = NULL; memst = 0; /* and the memory measurements */
+  #ifdef __linux__                  /* close and forget */
+  closefds(); nwatch = 0;           /* the watched files */
+  effsig = onlsig = 0;
+  #endif
+  purge();                          /* delete the retired objects */
+  ATOMIC_STORE(&gen, gen+1);        /* start a new generation */
+}  /* reset() */
+
+/*--------------------------------------------------------------------------*/
+
+static void renew (void)
+{                                   /* --- reload the loaded data */
+  const CPUTOPO *t;                 /* new processor topology */
+  CURTAB        *c;                 /* new table of cpu locations */
+  void          *old;               /* replaced object */
+
+  #if defined __linux__ && defined HAVE_HWLOC
+  if (loaded(&hwst)) {              /* reload the hwloc topology */
+    old = hwtopo; ATOMIC_STOREP(&hwtopo, loadhwloc());
+    retire(delhwloc, old);          /* (objects are replaced, */
+  }                                 /* but not deleted, so that */
+  #endif                            /* other threads can use them) */
+  if (loaded(&topost)) {            /* reload the topology */
+    old = topo; ATOMIC_STOREP(&topo, loadtopo());
+    retire(free, old);              /* (build a new object, publish */
+  }                                 /* it, retire the old object) */
+  if (cpuinfo_topology(&t) != 0) t = NULL;
+  if (loaded(&cachest)) {           /* reload the caches */
+    old = caches; ATOMIC_STOREP(&caches, (t) ? loadcaches(t) : NULL);
+    retire(delcaches, old);
+  }
+  if (loaded(&numast)) {            /* reload the NUMA topology */
+    old = numa; ATOMIC_STOREP(&numa, (t) ? loadnuma(t) : NULL);
+    retire(free, old);
+  }
+  if (loaded(&effst)) {             /* recompute the effective */
+    old = eff; ATOMIC_STOREP(&eff, loadeff());
+    retire(free, old);              /* cpu resources */
+  }
+  if (loaded(&curst) && ((c = loadcur()) != NULL)) {
+    old = curtab; ATOMIC_STOREP(&curtab, c);
+    retire(free, old);              /* rebuild the location table */
+  }                                 /* (but keep the method) */
+  if (loaded(&cntst))               /* recount the processors */
+    enumerate();                    /* (keep the memory measurements) */
+}  /* renew() */
+
+/*--------------------------------------------------------------------------*/
+
+int cpuinfo_setroot (const char *path)
+{                                   /* --- set root for sysfs/procfs */
+  if (!path) path = "";             /* (NULL: the real system) */
+  if (strlen(path) >= sizeof(root)) return -1;
+  getroot();                        /* make sure the environment */
+  strcpy(root, path);               /* is not read afterwards */
+  reset();                          /* set the new root and */
+  return 0;                         /* reload everything on next use */
+}  /* cpuinfo_setroot() */
+
+/*--------------------------------------------------------------------------*/
+#ifdef __linux__                    /* if Linux system */
+
+static int onlinechg (void)
+{                                   /* --- check the online cpus */
+  const CPUTOPO *t;                 /* processor topology */
+  int           *ids, i, n, r;      /* online cpus, loop var., result */
+  char          buf[1024];          /* contents of the online file */
+  uint64_t      h = 0;              /* signature of the online cpus */
+
+  if ((ATOMIC_LOAD(&topost) != 2) && (ATOMIC_LOAD(&cntst) != 2))
+    return 0;                       /* nothing loaded, nothing changed */
+  if ((long)getpid() != watchpid) closefds();
+  n = readfd(&onlfd, CPUDIR "online", buf, sizeof(buf));
+  if ((n > 0) && (n < (int)sizeof(buf)-1)) {
+    h = fnv(FNVINIT, buf, (size_t)n) | 1;
+    if (h == onlsig) return 0;      /* compare with the last check */
+    ids = malloc(8192 *sizeof(int));/* and parse the list only */
+    n = (ids) ? parselist(buf, ids, 8192) : -1;
+    if (n <= 0) free(ids); }        /* if it changed (the hash must */
+  else                              /* belong to the parsed list) */
+    n = readlist(&ids, CPUDIR "online");
+  if (n <= 0) return -1;            /* read the online cpus */
+  if (ATOMIC_LOAD(&topost) == 2) {  /* if the topology is loaded, */
+    t = ATOMIC_LOADP(&topo);        /* compare the online cpus */
+    r = !t || (n != t->nprocs);
+    for (i = 0; !r && (i < n); i++)
+      r = (ids[i] >= t->ncpus) || (t->cpus[ids[i]].pkg < 0); }
+  else                              /* if only the counts are known, */
+    r = (n != nprocs);              /* compare the number of cpus */
+  free(ids);                        /* delete the cpu list */
+  onlsig = (r) ? 0 : h;             /* note the unchanged contents */
+  return r;                         /* return whether cpus changed */
+}  /* onlinechg() */
+
+#else  /* #ifdef __linux__ */
+
+static int onlinechg (void)
+{ return 0; }                       /* not yet implemented */
+
+#endif  /* #ifdef __linux__ .. #else .. */
+/*--------------------------------------------------------------------------*/
+
+int cpuinfo_refresh (void)
+{                                   /* --- check for changed cpus */
+  CPUEFF *e, *old;                  /* new and old effective resources */
+  int    r = 0;                     /* changes (CPU_CHANGE_*) */
+  long   g;                         /* new generation */
+
+  if (fromfile()) return 0;         /* an imported description is fixed */
+  while (!ATOMIC_CAS(&refst, 0, 1)) /* serialize the refreshes */
+    SPIN_PAUSE();                   /* (they take at most milliseconds) */
+  switch (onlinechg()) {            /* if cpus went online/offline, */
+    case -1: r = -1; break;         /* reload all loaded data */
+    case  0: break;                 /* (except the feature snapshot) */
+    default: renew(); r = CPU_CHANGE_ONLINE; break;
+  }
+  if (!r && loaded(&effst) && effchg()) {
+    e = loadeff(); old = eff;       /* recompute effective resources */
+    if (e && (!old || (e->nallowed != old->nallowed)
+    ||        (e->quota != old->quota)
+    ||        (memcmp(&e->allowed, &old->allowed, sizeof(CPUSET)) != 0))) {
+      ATOMIC_STOREP(&eff, e); retire(free, old); r = CPU_CHANGE_ALLOWED; }
+    else free(e);                   /* replace them if they changed */
+  }                                 /* (and retire the old ones) */
+  g = gen +((r > 0) ? 1 : 0);       /* start a new generation */
+  ATOMIC_STORE(&gen, g);            /* after publishing the new data */
+  ATOMIC_STORE(&refst, 0);          /* and release the refresh lock */
+  if ((r > 0) && hook) hook(g, r, hookdata);
+  return r;                         /* call the notification hook */
+}  /* cpuinfo_refresh() */
+
+/*--------------------------------------------------------------------------*/
+
+long cpuinfo_generation (void)
+{                                   /* --- get the data generation */
+  return ATOMIC_LOAD(&gen);
+}  /* cpuinfo_generation() */
+
+/*--------------------------------------------------------------------------*/
+
+void cpuinfo_onchange (CPUHOOK *fn, void *data)
+{                                   /* --- set the notification hook */
+  hook = fn; hookdata = data;
+}  /* cpuinfo_onchange() */
+
+/*----------------------------------------------------------------------------
+Additional info (cpuinfo_refresh):
+  All data is loaded once and then cached. When cpus are hot-plugged or
+  the cpuset of the process is resized, cpuinfo_refresh() detects this:
+  it re-reads the list of online cpus (one small file) and, if this did
+  not change, checks the inputs of the effective resources (affinity
+  mask, cpuset and quota), but only for data that was already loaded.
+  To keep the common case (nothing changed) cheap, the files are kept
+  open and re-read with pread() (which regenerates their contents), and
+  only a hash of their contents is compared with the one of the last
+  check: the list of online cpus is parsed and the effective resources
+  are recomputed only if these hashes differ. (The watched files are
+  those read by the last computation, i.e. /proc/self/cgroup and the
+  cpuset and quota files of the cgroup and its ancestors; the files are
+  reopened in a child process after fork().) If the online cpus
+  changed, all loaded data except the feature snapshot is rebuilt; if
+  only the allowed cpus or the quota changed, only the effective
+  resources are replaced. The result is a bit mask
+  of the changes (CPU_CHANGE_*), and each change starts a new generation
+  (as does cpuinfo_setroot()). Workers can poll cpuinfo_generation(),
+  which is a single atomic load, and resize their pools if it differs
+  from the generation they were sized for; alternatively, a hook set
+  with cpuinfo_onchange() is called by cpuinfo_refresh() on a change.
+  cpuinfo_refresh() may run concurrently with all other queries (and
+  with itself; refreshes are serialized with a spin lock). The new
+  topology, caches, NUMA nodes, effective resources and cpu location
+  table are built completely before they are published with an atomic
+  pointer store, and the generation is incremented only afterwards.
+  Replaced objects are not deleted, but kept on a list, so that pointers
+  obtained before a change stay valid (though they describe the old
+  state); they are deleted only by cpuinfo_setroot() and
+  cpuinfo_import(), which must not run concurrently with other queries.
+  As hot-plugging is rare, the memory kept this way is negligible. The
+  counts (physcnt() etc.) are recomputed in place and may briefly be
+  inconsistent with each other; the memory measurements are kept.
+----------------------------------------------------------------------------*/
+
+int cpuinfo_export (const char *path)
+{                                   /* --- export a description file */
+  FILE           *fp;               /* file to write */
+  FILEHDR        h;                 /* file header */
+  const CPUTOPO  *t;                /* processor topology */
+  const CPUCACHE *c;                /* cache descriptions */
+  const CPUNUMA  *m;                /* NUMA node topology */
+  const CPUEFF   *e;                /* effective cpu resources */
+  int            v[9], i, n, k, z;  /* parameters, loop var., sizes */
+
+  if (cpuinfo_topology(&t) != 0) return -1;
+  v[0] = physcnt(); v[1] = corecnt(); v[2] = proccnt();
+  cpuinfo_effective(&e);            /* load all data */
+  fp = fopen(path, "wb");           /* and open the file */
+  if (!fp) return -1;
+  hdrinit(&h);                      /* write header, snapshot, counts */
+  fwrite(&h, sizeof(h), 1, fp);
+  fwrite(cpuinfo_get(), sizeof(CPUINFO), 1, fp);
+  fwrite(v, sizeof(int), 3, fp);
+  v[0] = t->ncpus;  v[1] = t->nprocs; v[2] = t->ncores;
+  v[3] = t->ndies;  v[4] = t->npkgs;  v[5] = t->flags & ~CPUTOPO_FILE;
+  for (i = 0; i < CPU_CORE_TYPES; i++) v[6+i] = t->ntype[i];
+  fwrite(v, sizeof(int), 9, fp);    /* write the topology */
+  fwrite(t->cpus,     sizeof(CPULOC), (size_t)t->ncpus,    fp);
+  fwrite(t->coreoff,  sizeof(int),    (size_t)t->ncores+1, fp);
+  fwrite(t->corecpus, sizeof(int),    (size_t)t->nprocs,   fp);
+  n = cpuinfo_caches(&c);           /* write the caches */
+  fwrite(&n, sizeof(int), 1, fp);   /* with their instances */
+  z = t->ncpus +2*t->nprocs +1;     /* (instoff and instcpus follow */
+  for (k = 0; k < n; k++) {         /* inst in one memory block) */
+    fwrite(c +k,      offsetof(CPUCACHE, inst), 1, fp);
+    fwrite(c[k].inst, sizeof(int), (size_t)z, fp);
+  }
+  n = (cpuinfo_numa(&m) == 0) ? m->nnodes : 0;
+  fwrite(&n, sizeof(int), 1, fp);   /* write the NUMA topology */
+  if (n > 0) {                      /* (dist, cpunode, nodeoff and */
+    fwrite(m->nodes, sizeof(CPUNODE), (size_t)n, fp);   /* nodecpus */
+    fwrite(m->dist,  sizeof(int), (size_t)(n*n +2*t->ncpus +n+1), fp);
+  }                                 /* follow in one memory block) */
+  fwrite(e, sizeof(CPUEFF), 1, fp); /* write the effective resources */
+  return (ferror(fp) | fclose(fp)) ? -1 : 0;
+}  /* cpuinfo_export() */
+
+/*--------------------------------------------------------------------------*/
+
+int cpuinfo_import (const char *path)
+{                                   /* --- import a description file */
+  if (!path) path = "";             /* (NULL: the real system) */
+  if (strlen(path) >= sizeof(desc)) return -1;
+  strcpy(desc, path); fileset = 1;  /* set the file name, */
+  reset();                          /* discard all loaded data */
+  if (ATOMIC_LOAD(&state) == 2)     /* redo an initialized snapshot */
+    initsnap();                     /* (which imports the file) */
+  return (!*path || fromfile()) ? 0 : -1;
+}  /* cpuinfo_import() */
+
+/*----------------------------------------------------------------------------
+Additional info (cpuinfo_export/cpuinfo_import):
+  The complete description of a machine (feature snapshot, counts,
+  topology, caches, NUMA nodes and effective resources) can be written
+  to a compact binary file and read back, either with cpuinfo_import()
+  or, on first use, from the file named by the environment variable
+  CPUINFO_FILE. Nothing is read from cpuid, sysfs or procfs then (except
+  the local feature snapshot), which makes the startup of short-lived
+  processes cheap and allows to reproduce e.g. the placement decisions
+  of a large server on a small machine. The usable features are the
+  intersection of the imported and the local ones, so that dispatched
+  functions never use instructions the executing cpu lacks. Of the
+  feature snapshot only the features reported by cpuid (present), the
+  logical processors per package and the CLFLUSH line size are taken
+  from the file; the vendor, signature and cpuid limits, XCR0 (so that
+  cpuinfo_xstate() tests the local OS state) and the TSC data (so that
+  cpuinfo_ticks() is calibrated for the local clock) stay those of the
+  executing cpu, and the AVX10 version is the smaller one. The file
+  stores the structures in the native layout; its header holds a magic
+  string, a format version and the sizes of the structures, and files
+  of other versions or platforms (word size, byte order) are rejected.
+  An imported description takes precedence over a fake root (see
+  cpuinfo_setroot()) until cpuinfo_import(NULL) returns to probing, and
+  it is not changed by cpuinfo_refresh(). As for
+  cpuinfo_setroot(), cpuinfo_import() discards all loaded data and must
+  not be called while other threads use the module.
+----------------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------------
+Additional info and references (cpuinfo_effective):
+  The number of logical processors that a process can actually use is
+  limited by its affinity mask (sched_getaffinity), which the kernel
+  also restricts to the cpus of its cpuset (cgroup v1/v2), and by the
+  cpu bandwidth quota of its cgroup and all ancestor cgroups (cpu.max
+  for cgroup v2, cpu.cfs_quota_us/cpu.cfs_period_us for cgroup v1).
+  A quota of q cpus lets all allowed cpus run, but throttles the
+  process once it used q cpus' worth of time per period, so more than
+  ceil(q) busy threads do not help. The cgroup hierarchies are expected
+  at their usual mount points (/sys/fs/cgroup, /sys/fs/cgroup/cpu etc.),
+  which is also what container runtimes provide.
+  For testing, all sysfs and procfs files can be read relative to a fake
+  root directory, given by the environment variable CPUINFO_ROOT or set
+  with cpuinfo_setroot(). The affinity mask is then taken from the
+  Cpus_allowed_list of <root>/proc/self/status and cpuid is not used
+  for the topology. cpuinfo_setroot() discards all loaded data and must
+  not be called while other threads use the module.
+  kernel.org/doc/Documentation/admin-guide/cgroup-v2.rst
+  kernel.org/doc/Documentation/scheduler/sched-bwc.rst
+----------------------------------------------------------------------------*/
+static int cmpkeys (const void *p, const void *q)
+{                                   /* --- compare placement keys */
+  const PLACEKEY *a = (PLACEKEY*)p; /* type the given pointers */
+  const PLACEKEY *b = (PLACEKEY*)q; /* (PLACEKEY array elements) */
+  int i;                            /* loop variable */
+  for (i = 0; i < 3; i++) {         /* compare the keys */
+    if (a->k[i] < b->k[i]) return -1;
+    if (a->k[i] > b->k[i]) return +1;
+  }
+  return (a->cpu > b->cpu) - (a->cpu < b->cpu);
+}  /* cmpkeys() */
+
+/*--------------------------------------------------------------------------*/
+
+static int groups (CPUSET *sets, int n, const int *gid, int ng,
+                   const CPUSET *allowed, int ncpus)
+{                                   /* --- one worker per group of cpus */
+  CPUSET *g;                        /* cpu sets of the groups */
+  int    i, k, m;                   /* loop variables, # nonempty groups */
+
+  g = calloc((size_t)ng, sizeof(CPUSET));
+  if (!g) return -1;                /* collect the allowed cpus */
+  for (i = 0; (i < ncpus) && (i < CPUSET_MAX); i++)  /* per group */
+    if (CPUSET_ISSET(allowed, i) && (gid[i] >= 0) && (gid[i] < ng))
+      CPUSET_SET(g +gid[i], i);
+  for (m = k = 0; k < ng; k++)      /* remove empty groups */
+    if (cpuset_count(g+k) > 0) g[m++] = g[k];
+  for (i = 0; (m > 0) && (i < n); i++)
+    sets[i] = g[i % m];             /* assign the groups round robin */
+  free(g);                          /* delete the group sets */
+  return m;                         /* return the number of groups */
+}  /* groups() */
+
+/*--------------------------------------------------------------------------*/
+
+int cpuinfo_place (int n, int policy, CPUSET *sets)
+{                                   /* --- place workers on cpus */
+  const CPUTOPO  *t;                /* processor topology */
+  const CPUEFF   *e;                /* effective cpu resources */
+  const CPUCACHE *l3;               /* last level cache */
+  const CPUNUMA  *m;                /* NUMA node topology */
+  PLACEKEY       *keys;             /* placement keys of the cpus */
+  int            *first;            /* first core per package */
+  int            i, k, r;           /* loop variables, result */
+  int            a, c;              /* sibling index, core index */
+  const int      *gid;              /* group ids of the cpus */
+  int            *pkgs;             /* package per cpu (fallback) */
+  long           g;                 /* generation of the loaded data */
+
+  if (n < 0) return -1;             /* check the number of workers */
+  do {                              /* get the topology, resources and */
+    while (ATOMIC_LOAD(&refst))     /* groups of one generation (wait */
+      SPIN_PAUSE();                 /* for a running refresh and retry */
+    g  = ATOMIC_LOAD(&gen);         /* if one replaced them meanwhile) */
+    r  = cpuinfo_topology(&t);      /* (cpuinfo_effective() always */
+    r |= cpuinfo_effective(&e);     /* sets e, if only to no cpus) */
+    l3 = (policy == CPU_PLACE_L3) ? cpuinfo_cache(3, CPUCACHE_DATA) : NULL;
+    if ((policy != CPU_PLACE_NUMA) || (cpuinfo_numa(&m) != 0)) m = NULL;
+  } while (ATOMIC_LOAD(&refst) || (ATOMIC_LOAD(&gen) != g));
+  if (r) return -1;                 /* check for a usable topology */
+  memset(sets, 0, (size_t)n *sizeof(CPUSET));
+  if ((policy == CPU_PLACE_L3) || (policy == CPU_PLACE_NUMA)) {
+    gid = NULL; pkgs = NULL; k = 0; /* if to place per cache or node */
+    if (l3) { gid = l3->inst;   k = l3->ninst; }
+    if (m)  { gid = m->cpunode; k = m->nnodes; }
+    if (!gid) {                     /* if there is no such information, */
+      pkgs = malloc((size_t)t->ncpus *sizeof(int));
+      if (!pkgs) return -1;         /* fall back to the packages */
+      for (i = 0; i < t->ncpus; i++) pkgs[i] = t->cpus[i].pkg;
+      gid = pkgs; k = t->npkgs;
+    }
+    r = groups(sets, n, gid, k, &e->allowed, t->ncpus);
+    free(pkgs);                     /* build one set per group */
+    return r;                       /* and return the number of groups */
+  }
+  keys  = malloc((size_t)t->nprocs *sizeof(PLACEKEY));
+  first = malloc((size_t)t->npkgs  *sizeof(int));
+  if (!keys || !first) { free(keys); free(first); return -1; }
+  for (i = t->ncpus; --i >= 0; )    /* find the first core */
+    if ((t->cpus[i].pkg >= 0) && (t->cpus[i].pkg < t->npkgs))
+      first[t->cpus[i].pkg] = t->cpus[i].core;  /* of each package */
+  for (k = i = 0; (i < t->ncpus) && (k < t->nprocs); i++) {
+    if ((i >= CPUSET_MAX) || !CPUSET_ISSET(&e->allowed, i)
+    ||  (t->cpus[i].pkg < 0) || (t->cpus[i].pkg >= t->npkgs))
+      continue;                     /* skip forbidden and offline cpus */
+    keys[k].cpu = i;                /* traverse the allowed cpus */
+    if (policy == CPU_PLACE_SCATTER) {  /* siblings last, packages */
+      keys[k].k[0] = t->cpus[i].smt;    /* round robin */
+      keys[k].k[1] = t->cpus[i].core -first[t->cpus[i].pkg];
+      keys[k].k[2] = t->cpus[i].pkg; }
+    else {                          /* compact: package by package, */
+      keys[k].k[0] = t->cpus[i].pkg;/* core by core, siblings next */
+      keys[k].k[1] = t->cpus[i].core;  /* to each other */
+      keys[k].k[2] = t->cpus[i].smt;
+    }
+    k++;                            /* count the allowed cpus */
+  }
+  free(first);                      /* sort the placement keys */
+  qsort(keys, (size_t)k, sizeof(PLACEKEY), cmpkeys);
+  if (policy == CPU_PLACE_NOSMT) {  /* if to avoid SMT siblings, */
+    for (r = i = 0; i < k; i++)     /* give each worker whole cores */
+      if ((i == 0) || (t->cpus[keys[i].cpu].core
+                   !=  t->cpus[keys[i-1].cpu].core))
+        keys[r++] = keys[i];        /* (one key per core) */
+    for (i = 0; (r > 0) && (i < n); i++) {
+      c = t->cpus[keys[i % r].cpu].core;  /* assign the cores */
+      for (a = t->coreoff[c]; a < t->coreoff[c+1]; a++)  /* round robin */
+        if ((t->corecpus[a] < CPUSET_MAX)
+        &&  CPUSET_ISSET(&e->allowed, t->corecpus[a]))
+          CPUSET_SET(sets +i, t->corecpus[a]);
+    } }                             /* (only allowed siblings) */
+  else {                            /* if to place on single cpus, */
+    for (i = 0; (k > 0) && (i < n); i++)   /* assign the cpus */
+      CPUSET_SET(sets +i, keys[i % k].cpu);   /* round robin */
+    r = k;                          /* note the number of cpus */
+  }
+  free(keys);                       /* delete the placement keys */
+  return r;                         /* return the number of places */
+}  /* cpuinfo_place() */
+
+/*--------------------------------------------------------------------------*/
+
+int cpuinfo_pin (const CPUSET *set)
+{                                   /* --- pin the calling thread */
+  #ifdef __linux__                  /* if Linux system */
+  cpu_set_t cs;                     /* affinity mask */
+  int       i;                      /* loop variable */
+  CPU_ZERO(&cs);                    /* copy the cpu set */
+  for (i = 0; (i < CPUSET_MAX) && (i < CPU_SETSIZE); i++)
+    if (CPUSET_ISSET(set, i)) CPU_SET((size_t)i, &cs);
+  return sched_setaffinity(0, sizeof(cs), &cs) ? -1 : 0;
+  #else                             /* set the affinity of the thread */
+  return -1;                        /* not yet implemented */
+  #endif
+}  /* cpuinfo_pin() */
+
+/*--------------------------------------------------------------------------*/
+
+int cpuinfo_partition (int total, int n, const CPUSET *sets, int *cnts)
+{                                   /* --- split work by capacities */
+  const CPUTOPO *t;                 /* processor topology */
+  double *w, sum = 0, x;            /* weights of the sets, sum */
+  char   *seen;                     /* flags for the cores of a set */
+  int    i, c, m, k, rest;          /* loop variables, remaining items */
+
+  if ((n <= 0) || (total < 0)) return -1;
+  if (cpuinfo_topology(&t) != 0) t = NULL;
+  w    = malloc((size_t)n *sizeof(double));
+  seen = malloc((t) ? (size_t)t->ncores : 1);
+  if (!w || !seen) { free(w); free(seen); return -1; }
+  m = (t && (t->ncpus < CPUSET_MAX)) ? t->ncpus : CPUSET_MAX;
+  for (i = 0; i < n; i++) {         /* traverse the cpu sets */
+    if (t) memset(seen, 0, (size_t)t->ncores);
+    for (w[i] = 0, c = 0; c < m; c++) {
+      if (!CPUSET_ISSET(sets +i, c)) continue;
+      if (!t) { w[i] += CPU_CAPACITY_MAX; continue; }
+      if ((t->cpus[c].core < 0) || seen[t->cpus[c].core]) continue;
+      seen[t->cpus[c].core] = 1;    /* count each core only once, */
+      w[i] += t->cpus[c].capacity;  /* as SMT siblings share the */
+    }                               /* execution units of the core */
+    sum += w[i];                    /* sum the capacities of the cores */
+  }
+  free(seen);                       /* delete the core flags */
+  for (rest = total, i = 0; i < n; i++) {
+    x = (sum > 0) ? (double)total *w[i] /sum : (double)total /n;
+    cnts[i] = (int)x;               /* distribute the items */
+    w[i]    = x -cnts[i];           /* proportionally to the weights */
+    rest   -= cnts[i];              /* and note the remainders */
+  }
+  while (rest-- > 0) {              /* distribute the remaining items */
+    for (k = 0, i = 1; i < n; i++)  /* by largest remainder */
+      if (w[i] > w[k]) k = i;
+    cnts[k]++; w[k] = -1;
+  }
+  free(w);                          /* delete the weights */
+  return 0;                         /* return 'ok' */
+}  /* cpuinfo_partition() */
+
+/*----------------------------------------------------------------------------
+Additional info (cpuinfo_place):
+  The placement is computed from the package and core indices of the
+  topology map, restricted to the cpus the process may use (see
+  cpuinfo_effective()). With CPU_PLACE_COMPACT, workers get single cpus
+  package by package and core by core, with SMT siblings adjacent (best
+  for sharing caches). With CPU_PLACE_SCATTER, workers get single cpus
+  alternating between the packages, one per core, SMT siblings only
+  after all cores are used (best for memory bandwidth). With
+  CPU_PLACE_NOSMT, each worker gets a whole core, so that no two workers
+  share a core unless there are more workers than cores.
+  CPU_PLACE_L3 and CPU_PLACE_NUMA give each worker all allowed cpus of
+  an L3 cache instance or a NUMA node (falling back to packages).
+  If there are more workers than places, places are reused round robin;
+  the return value is the number of distinct places.
+  cpuinfo_partition() splits a number of work items over such cpu sets
+  in proportion to the summed capacities of the cores in each set, so
+  that workers on efficiency cores of a hybrid processor get fewer
+  items and do not become stragglers (static weighted partitioning).
+  SMT siblings count only once, as they share the core.
+----------------------------------------------------------------------------*/
+/*--------------------------------------------------------------------------*/
+
+static inline uint64_t tscp (void)
+{                                   /* --- read the TSC with rdtscp */
+  #ifdef _WIN32                     /* if Microsoft Windows system */
+  unsigned int aux;                 /* processor id (TSC_AUX) */
+  return __rdtscp(&aux);            /* use the compiler intrinsic */
+  #else                             /* if Linux/Unix system */
+  uint32_t lo, hi, aux;             /* low and high word of the TSC */
+  __asm__ __volatile__ ("rdtscp" : "=a" (lo), "=d" (hi), "=c" (aux)
+                        : : "memory");
+  return ((uint64_t)hi << 32) | lo;
+  #endif
+}  /* tscp() */
+
+/*--------------------------------------------------------------------------*/
+
+static inline uint64_t tscf (void)
+{                                   /* --- read the TSC after lfence */
+  #ifdef _WIN32                     /* if Microsoft Windows system */
+  _mm_lfence();                     /* use the compiler intrinsics */
+  return __rdtsc();
+  #else                             /* if Linux/Unix system */
+  uint32_t lo, hi;                  /* low and high word of the TSC */
+  __asm__ __volatile__ ("lfence\n\trdtsc" : "=a" (lo), "=d" (hi)
+                        : : "memory");
+  return ((uint64_t)hi << 32) | lo;
+  #endif
+}  /* tscf() */
+
+/*--------------------------------------------------------------------------*/
+
+static inline uint64_t clockticks (void)
+{                                   /* --- read the monotonic clock */
+  #ifdef _WIN32                     /* if Microsoft Windows system */
+  LARGE_INTEGER c;                  /* performance counter */
+  QueryPerformanceCounter(&c);
+  return (uint64_t)c.QuadPart;
+  #else                             /* if Linux/Unix system */
+  struct timespec ts;               /* (nanoseconds) */
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec *1000000000u +(uint64_t)ts.tv_nsec;
+  #endif
+}  /* clockticks() */
+
+/*--------------------------------------------------------------------------*/
+
+static inline uint64_t ticks (void)
+{                                   /* --- read the ticks of the timer */
+  switch (timer.read) {             /* evaluate the read method */
+    case CPUTIMER_READ_RDTSCP: return tscp();
+    case CPUTIMER_READ_LFENCE: return tscf();
+    default:                   return clockticks();
+  }                                 /* (rdtscp waits for all preceding */
+}  /* ticks() */                    /* instructions, lfence as well) */
+
+/*--------------------------------------------------------------------------*/
+
+static double clockhz (void)
+{                                   /* --- frequency of the clock */
+  #ifdef _WIN32                     /* if Microsoft Windows system */
+  LARGE_INTEGER f;                  /* performance counter frequency */
+  QueryPerformanceFrequency(&f);
+  return (double)f.QuadPart;
+  #else                             /* if Linux/Unix system, */
+  return 1e9;                       /* the clock counts nanoseconds */
+  #endif
+}  /* clockhz() */
+
+/*--------------------------------------------------------------------------*/
+
+static int tscsafe (void)
+{                                   /* --- check whether TSC is usable */
+  #ifdef __linux__                  /* if Linux system */
+  char buf[256];                    /* buffer for clock sources */
+  #endif
+
+  if (!getsnap()->tscinv) return 0; /* TSC must be invariant */
+  #ifdef __linux__                  /* if Linux system */
+  if (readtxt(buf, sizeof(buf), "/sys/devices/system/clocksource/"
+              "clocksource0/available_clocksource") < 0)
+    return 1;                       /* the kernel drops the TSC from */
+  return strstr(buf, "tsc") != NULL;/* the clock sources if it finds */
+  #else                             /* it unstable (e.g. unsynchronized */
+  return 1;                         /* between the packages) */
+  #endif
+}  /* tscsafe() */
+
+/*--------------------------------------------------------------------------*/
+
+static double calibrate (void)
+{                                   /* --- calibrate the TSC frequency */
+  double   hz = clockhz();          /* frequency of the clock */
+  uint64_t c0, c1, t0, t1;          /* clock and TSC readings */
+
+  t0 = clockticks(); c0 = ticks();  /* measure the TSC ticks */
+  do { t1 = clockticks(); }         /* during 10 ms of the clock */
+  while ((double)(t1 -t0) < 0.01 *hz);
+  c1 = ticks();
+  return (double)(c1 -c0) *hz /(double)(t1 -t0);
+}  /* calibrate() */
+
+/*--------------------------------------------------------------------------*/
+
+static void inittimer (void)
+{                                   /* --- initialize the tick timer */
+  const CPUINFO *c = getsnap();     /* processor feature snapshot */
+  uint64_t a, b, d, ovh, res;       /* readings, min. differences */
+  int      i;                       /* loop variable */
+
+  timer.source = CPUTIMER_CLOCK;    /* default: system clock */
+  timer.read   = CPUTIMER_READ_CLOCK;
+  timer.hz     = clockhz();
+  if (tscsafe()) {                  /* if the TSC can be used */
+    timer.read = FEATGET(c, CPU_RDTSCP) /* read it in program order */
+               ? CPUTIMER_READ_RDTSCP : CPUTIMER_READ_LFENCE;
+    if (c->tscnum && c->tscden && c->crystal) {
+      timer.source = CPUTIMER_TSC;  /* frequency from leaf 0x15 */
+      timer.hz = (double)c->crystal *c->tscnum /c->tscden; }
+    else if (c->tscnum && c->tscden && c->basemhz) {
+      timer.source = CPUTIMER_TSC;  /* crystal unknown: the TSC runs */
+      timer.hz = c->basemhz *1e6; } /* at the base frequency */
+    else {                          /* otherwise calibrate the TSC */
+      timer.source = CPUTIMER_TSCCAL;
+      timer.hz = calibrate();       /* against the system clock */
+    }
+  }
+  timer.nspt = 1e9 /timer.hz;       /* compute nanoseconds per tick */
+  ovh = res = UINT64_MAX;           /* measure overhead and resolution */
+  for (i = 0; i < 1000; i++) {      /* (minimum over several tries) */
+    a = ticks(); b = ticks();       /* back-to-back readings */
+    if ((d = b -a) < ovh) ovh = d;
+    while (b == a) b = ticks();     /* wait for the next step */
+    if ((d = b -a) < res) res = d;  /* smallest nonzero step */
+  }                                 /* (the TSC steps by single ticks, */
+  if (timer.source != CPUTIMER_CLOCK) res = 1; /* but reading takes */
+  timer.overhead   = (double)ovh *timer.nspt;
+  timer.resolution = (double)res *timer.nspt;
+}  /* inittimer() */
+
+/*--------------------------------------------------------------------------*/
+
+const CPUTIMER* cpuinfo_timer (void)
+{                                   /* --- get the tick timer */
+  if (ATOMIC_LOAD(&timest) != 2) once(&timest, inittimer);
+  return &timer;                    /* initialize on first use only */
+}  /* cpuinfo_timer() */
+
+/*--------------------------------------------------------------------------*/
+
+uint64_t cpuinfo_ticks (void)
+{                                   /* --- read the tick timer */
+  if (ATOMIC_LOAD(&timest) != 2) once(&timest, inittimer);
+  return ticks();                   /* read the configured counter */
+}  /* cpuinfo_ticks() */
+
+/*--------------------------------------------------------------------------*/
+
+double cpuinfo_ticks_to_ns (uint64_t ticks)
+{                                   /* --- convert ticks to nanoseconds */
+  if (ATOMIC_LOAD(&timest) != 2) once(&timest, inittimer);
+  return (double)ticks *timer.nspt;
+}  /* cpuinfo_ticks_to_ns() */
+
+/*----------------------------------------------------------------------------
+Additional info and references (cpuinfo_ticks):
+  The time stamp counter is used only if it is invariant (constant rate
+  in all P-, C- and T-states, CPUID.80000007H:EDX[8]) and, on Linux, if
+  the kernel still lists it as an available clock source (it removes the
+  TSC if its watchdog finds it unstable or unsynchronized between
+  packages). Its frequency is the crystal clock frequency times the
+  ratio EBX/EAX of leaf 0x15; if the crystal frequency is not reported
+  (e.g. Skylake client), the TSC runs at the base frequency of leaf
+  0x16. Otherwise (AMD, most hypervisors) it is calibrated once against
+  the monotonic clock over 10ms. If the TSC cannot be used, the ticks
+  are those of clock_gettime(CLOCK_MONOTONIC) or QueryPerformanceCounter.
+  Plain rdtsc is not ordered with respect to surrounding instructions:
+  it may execute before earlier instructions have completed, so short
+  intervals come out too small. The TSC is therefore read with rdtscp
+  (CPUID.80000001H:EDX[27]), which waits until all preceding
+  instructions have executed, or, if that is missing, with lfence;rdtsc
+  (lfence is dispatch serializing on Intel and on AMD with current
+  kernels). CPUTIMER.read reports which one is used. Later instructions
+  may still start before the reading; a caller that needs this ordering
+  as well must add an lfence after cpuinfo_ticks(). The overhead is the
+  minimum difference of two back-to-back readings.
+  The resolution is one tick for the TSC and the smallest nonzero step
+  between readings for the system clock.
+  Intel SDM vol. 3B, sect. 18.17 (Time-Stamp Counter)
+  kernel.org/doc/html/latest/virt/kvm/x86/timekeeping.html
+----------------------------------------------------------------------------*/
+#if (defined __x86_64__ || defined __i386__) && !defined _MSC_VER
+
+static inline int rdpid (void)
+{                                   /* --- read TSC_AUX with RDPID */
+  unsigned long aux;                /* processor id (TSC_AUX) */
+  __asm__ __volatile__ (".byte 0xf3, 0x0f, 0xc7, 0xf8" : "=a" (aux));
+  return (int)(aux & 0xfff);        /* (rdpid eax/rax, encoded for */
+}  /* rdpid() */                    /* assemblers without RDPID) */
+
+/*--------------------------------------------------------------------------*/
+
+static inline int rdtscp (void)
+{                                   /* --- read TSC_AUX with RDTSCP */
+  uint32_t lo, hi, aux;             /* time stamp counter, TSC_AUX */
+  __asm__ __volatile__ ("rdtscp" : "=a" (lo), "=d" (hi), "=c" (aux));
+  return (int)(aux & 0xfff);        /* the kernel stores the cpu in */
+}  /* rdtscp() */                   /* bits 0..11 (node in 12..31) */
+
+#else  /* #if (defined __x86_64__ || defined __i386__) && ... */
+
+static inline int rdpid (void)
+{ return -1; }                      /* not available */
+
+static inline int rdtscp (void)
+{ return -1; }                      /* not available */
+
+#endif  /* #if (defined __x86_64__ || defined __i386__) && ... #else .. */
+/*--------------------------------------------------------------------------*/
+
+static inline int curcpu (void)
+{                                   /* --- get the cpu from the OS */
+  #ifdef _WIN32                     /* if Microsoft Windows system */
+  return (int)GetCurrentProcessorNumber();
+  #elif defined __linux__           /* if Linux system */
+  return sched_getcpu();            /* (vDSO or getcpu system call) */
+  #else                             /* if other system */
+  return -1;                        /* not yet implemented */
+  #endif
+}  /* curcpu() */
+
+/*--------------------------------------------------------------------------*/
+
+static int check (int (*fn)(void))
+{                                   /* --- check a method on TSC_AUX */
+  int i;                            /* loop variable */
+  for (i = 0; i < 8; i++)           /* compare with the OS (retry */
+    if (fn() == curcpu()) return 1; /* in case the thread migrated) */
+  return 0;                         /* return whether the cpus agree */
+}  /* check() */
+
+/*--------------------------------------------------------------------------*/
+
+static uint64_t cost (int (*fn)(void))
+{                                   /* --- measure the cost of a method */
+  int          i;                   /* loop variable */
+  volatile int s = 0;               /* result sum (not optimized away) */
+  uint64_t     t;                   /* time of the calls */
+
+  t = clockticks();                 /* time some calls */
+  for (i = 0; i < 256; i++) s += fn();
+  t = clockticks() -t;
+  return t;                         /* return the time of the calls */
+}  /* cost() */
+
+/*--------------------------------------------------------------------------*/
+
+static void initcur (void)
+{                                   /* --- set up the current cpu query */
+  static int (*const fns[])(void) = { 0, rdpid, rdtscp, curcpu };
+  CURTAB   *tab;                    /* table of cpu locations */
+  int      i, n, m = 0;             /* loop variable, number of cpus */
+  uint64_t d, min = 0;              /* cost of a method, minimum */
+
+  tab = loadcur();                  /* build the location table */
+  if (!tab) return;                 /* and publish it */
+  ATOMIC_STOREP(&curtab, tab); n = tab->n;
+  if (curcpu() < 0) { curmeth = CPUCUR_NONE; return; }
+  for (i = CPUCUR_RDPID; i <= CPUCUR_GETCPU; i++) {
+    #ifdef __linux__                /* TSC_AUX holds the cpu on Linux */
+    if (((i == CPUCUR_RDPID)  && !hasRDPID())
+    ||  ((i == CPUCUR_RDTSCP) && !hasRDTSCP())
+    ||  ((i != CPUCUR_GETCPU) && ((n > 4096) || !check(fns[i]))))
+      continue;                     /* check whether TSC_AUX is usable */
+    #else
+    if (i != CPUCUR_GETCPU) continue;
+    #endif
+    d = cost(fns[i]);               /* measure the cost of the method */
+    if ((m <= 0) || (d < min)) { m = i; min = d; }
+  }                                 /* find the fastest method */
+  curmeth = m;                      /* and note it */
+}  /* initcur() */
+
+/*--------------------------------------------------------------------------*/
+
+const CPUCUR* cpuinfo_current (void)
+{                                   /* --- get the current cpu */
+  const CURTAB *tab;                /* table of cpu locations */
+  int          c;                   /* current logical cpu */
+
+  if (ATOMIC_LOAD(&curst) != 2) once(&curst, initcur);
+  switch (curmeth) {                /* read the cpu number */
+    case CPUCUR_RDPID:  c = rdpid();  break;
+    case CPUCUR_RDTSCP: c = rdtscp(); break;
+    case CPUCUR_GETCPU: c = curcpu(); break;
+    default:            return &curnone;
+  }                                 /* look up its location */
+  tab = ATOMIC_LOADP(&curtab);      /* (exists if a method is set) */
+  return ((unsigned)c < (unsigned)tab->n) ? tab->c +c : &curnone;
+}  /* cpuinfo_current() */
+
+/*--------------------------------------------------------------------------*/
+
+int cpuinfo_curmethod (void)
+{                                   /* --- get the method used */
+  if (ATOMIC_LOAD(&curst) != 2) once(&curst, initcur);
+  return curmeth;                   /* return the method (CPUCUR_*) */
+}  /* cpuinfo_curmethod() */
+
+/*----------------------------------------------------------------------------
+Additional info (cpuinfo_current):
+  The current logical cpu is read either from the TSC_AUX register,
+  which Linux sets on every cpu to the cpu number (bits 0..11) and the
+  node number (bits 12..31), with RDPID (if cpuid reports it) or with
+  RDTSCP (which also reads the time stamp counter), or it is obtained
+  from the OS with sched_getcpu() (vDSO or getcpu() system call, or a
+  plain load from the rseq area with glibc 2.35 or later, which can be
+  as fast as RDPID, in particular in VMs).
+  The methods using TSC_AUX are checked against sched_getcpu() and are
+  used only for at most 4096 cpus; of the usable methods the fastest
+  one is chosen with a short measurement. The cpu number is then
+  mapped to its core, package, NUMA node and L3 domain with a flat table
+  that is built once from the topology, so that a call takes only a few
+  nanoseconds. As the thread may migrate at any time, the result is
+  only a hint: it is meant for choosing a shard of a per-cpu data
+  structure (e.g. counters or free lists), where an occasional wrong
+  choice merely costs some contention, not for correctness. Masking
+  rdpid and rdtscp with CPUINFO_FEATURES excludes these methods.
+  Intel SDM vol. 2B (RDPID, RDTSCP); man 2 getcpu
+----------------------------------------------------------------------------*/
+
+int cpuinfo_padsize (void)
+{                                   /* --- size to pad shared data to */
+  int n = cacheline();              /* get the L1 line size */
+  if (n <= 0) n = getsnap()->clsize;/* or the CLFLUSH line size */
+  if (n <= 0) n = 64;               /* (and assume 64 bytes if unknown) */
+  #if defined __x86_64__ || defined __i386__ || defined _M_X64
+  if (n < 128) n *= 2;              /* the spatial prefetcher fetches */
+  #endif                            /* pairs of lines on x86 */
+  return n;                         /* return the padding size */
+}  /* cpuinfo_padsize() */
+
+/*--------------------------------------------------------------------------*/
+
+void* cpuinfo_alloc (size_t size, size_t align)
+{                                   /* --- allocate aligned memory */
+  void *p;                          /* allocated memory block */
+
+  if (align == 0) align = (size_t)cpuinfo_padsize();
+  while (align & (align-1)) align &= align-1;
+  if (align < sizeof(void*)) align = sizeof(void*);
+  size = (size +align-1) & ~(align-1);
+  if (size == 0) size = align;      /* round the size to full lines, */
+  #ifdef _WIN32                     /* so that no other data shares */
+  p = _aligned_malloc(size, align); /* the last line of the block */
+  #else
+  if (posix_memalign(&p, align, size) != 0) p = NULL;
+  #endif
+  return p;                         /* return the memory block */
+}  /* cpuinfo_alloc() */
+
+/*--------------------------------------------------------------------------*/
+
+void cpuinfo_free (void *p)
+{                                   /* --- free aligned memory */
+  #ifdef _WIN32                     /* if Microsoft Windows system */
+  _aligned_free(p);
+  #else                             /* if Linux/Unix system */
+  free(p);
+  #endif
+}  /* cpuinfo_free() */
+
+/*--------------------------------------------------------------------------*/
+
+void* cpuinfo_percpu (size_t size, int *n, size_t *stride)
+{                                   /* --- allocate a per-cpu array */
+  const CPUTOPO *t;                 /* processor topology */
+  size_t        pad;                /* padding size */
+  int           k;                  /* number of slots */
+  void          *p;                 /* allocated array */
+
+  k = proccnt();                    /* one slot per logical cpu, */
+  if ((cpuinfo_topology(&t) == 0) && (t->ncpus > k))
+    k = t->ncpus;                   /* also for offline cpus */
+  if (k <= 0) k = 1;                /* (as cpu numbers may have gaps) */
+  pad  = (size_t)cpuinfo_padsize(); /* round the slot size */
+  size = (size +pad-1) /pad *pad;   /* to full padding units */
+  if (size == 0) size = pad;
+  p = cpuinfo_alloc((size_t)k *size, pad);
+  if (!p) return NULL;              /* allocate the array */
+  memset(p, 0, (size_t)k *size);    /* and clear it */
+  if (n)      *n      = k;          /* store the number of slots */
+  if (stride) *stride = size;       /* and the distance between them */
+  return p;                         /* return the per-cpu array */
+}  /* cpuinfo_percpu() */
+
+/*--------------------------------------------------------------------------*/
+#ifdef __linux__                    /* if Linux system */
+#define MPOL_PREF     1             /* MPOL_PREFERRED of <numaif.h> */
+
+static int touch (char *p, size_t size, int node)
+{                                   /* --- place pages by first touch */
+  const CPUNUMA *m;                 /* NUMA node topology */
+  cpu_set_t     old, cs;            /* affinity masks */
+  size_t        i, pg;              /* loop variable, page size */
+  int           k;                  /* loop variable */
+
+  if ((cpuinfo_numa(&m) != 0) || (m->nodeoff[node+1] <= m->nodeoff[node])
+  ||  sched_getaffinity(0, sizeof(old), &old)) return -1;
+  CPU_ZERO(&cs);                    /* collect the cpus of the node */
+  for (k = m->nodeoff[node]; k < m->nodeoff[node+1]; k++)
+    if (m->nodecpus[k] < CPU_SETSIZE) CPU_SET((size_t)m->nodecpus[k], &cs);
+  if (sched_setaffinity(0, sizeof(cs), &cs)) return -1;
+  pg = (size_t)sysconf(_SC_PAGESIZE);
+  for (i = 0; i < size; i += pg)    /* touch the pages on the node, */
+    p[i] = 0;                       /* so that they are allocated there */
+  sched_setaffinity(0, sizeof(old), &old);
+  return 0;                         /* restore the affinity mask */
+}  /* touch() */
+
+/*--------------------------------------------------------------------------*/
+
+void* cpuinfo_nodealloc (size_t size, int node)
+{                                   /* --- allocate memory on a node */
+  const CPUNUMA *m;                 /* NUMA node topology */
+  unsigned long mask[16];           /* node mask for mbind() */
+  void          *p;                 /* allocated memory block */
+  int           id;                 /* node number of the kernel */
+
+  if (size == 0) return NULL;       /* check the size */
+  p = mmap(NULL, size, PROT_READ|PROT_WRITE,
+           MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) return NULL; /* map anonymous memory */
+  if (node < 0) node = cpuinfo_current()->node;
+  if ((cpuinfo_numa(&m) != 0) || (node < 0) || (node >= m->nnodes))
+    return p;                       /* check the node index */
+  id = m->nodes[node].id;           /* get the node number */
+  if ((id < 0) || (id >= (int)(8*sizeof(mask)))) return p;
+  memset(mask, 0, sizeof(mask));    /* build the node mask */
+  mask[(size_t)id/(8*sizeof(long))] |= 1UL << ((size_t)id % (8*sizeof(long)));
+  #ifdef SYS_mbind                  /* prefer the node for the pages */
+  if (!*getroot() && (syscall(SYS_mbind, p, size, MPOL_PREF, mask,
+                              8*sizeof(mask), 0) == 0))
+    return p;                       /* (pages are placed on first use) */
+  #endif                            /* if mbind() is not available, */
+  touch((char*)p, size, node);      /* touch the pages from the node */
+  return p;                         /* return the memory block */
+}  /* cpuinfo_nodealloc() */
+
+/*--------------------------------------------------------------------------*/
+
+void cpuinfo_nodefree (void *p, size_t size)
+{                                   /* --- free memory of a node */
+  if (p) munmap(p, size);           /* unmap the memory */
+}  /* cpuinfo_nodefree() */
+
+/*--------------------------------------------------------------------------*/
+#else                               /* if other system */
+
+void* cpuinfo_nodealloc (size_t size, int node)
+{ return cpuinfo_alloc(size, 0); }  /* not yet implemented */
+
+void cpuinfo_nodefree (void *p, size_t size)
+{ cpuinfo_free(p); }                /* not yet implemented */
+
+#endif  /* #ifdef __linux__ .. #else .. */
+/*----------------------------------------------------------------------------
+Additional info and references (cpuinfo_alloc):
+  Data that different threads write must not share a cache line, or the
+  line bounces between their cores (false sharing). cpuinfo_padsize()
+  yields the distance to keep such data apart: the L1 line size (from
+  cpuid leaf 4 or sysfs, else the CLFLUSH line size, CPUID.1:EBX[15:8]
+  times 8), doubled on x86, where the spatial (adjacent-line) prefetcher
+  of Intel and AMD processors fetches 128-byte aligned pairs of lines,
+  so that a 64-byte padding still lets neighbors interfere. It is 128
+  bytes on current x86 and Apple processors. cpuinfo_alloc() rounds the
+  size up to the alignment (default: the padding size), so that the
+  block shares no line with other data; it is freed with cpuinfo_free().
+  cpuinfo_percpu() allocates a zeroed array with one padded slot per
+  logical cpu (slot c at (char*)p +c*stride, e.g. for the cpu of
+  cpuinfo_current()), so that counters or free lists of different cpus
+  never share a line. cpuinfo_nodealloc() maps memory whose pages are
+  preferably placed on the given node (dense index as in CPUNUMA, -1:
+  the node of the calling thread) with mbind(MPOL_PREFERRED), called
+  directly, so that libnuma is not needed; the pages are allocated on
+  first use. If mbind() fails (e.g. kernels without NUMA support or
+  seccomp filters), the pages are touched from a thread temporarily
+  pinned to the cpus of the node, so that the first-touch policy places
+  them there. The block must be freed with cpuinfo_nodefree() and the
+  same size. With a fake root only first-touch placement is used.
+  man 2 mbind; Intel Optimization Reference Manual, sect. 3.7.3
+----------------------------------------------------------------------------*/
+/*--------------------------------------------------------------------------*/
+
+static void** chain (char *buf, size_t size, size_t line)
+{                                   /* --- build a random pointer chain */
+  size_t   *idx, i, k, n, x;        /* line indices, loop variables */
+  uint64_t s = 0x9e3779b97f4a7c15u; /* state of the random generator */
+
+  n   = size /line;                 /* get the number of lines */
+  idx = malloc(n *sizeof(size_t));
+  if (!idx) return NULL;            /* allocate the line indices */
+  for (i = 0; i < n; i++) idx[i] = i;
+  for (i = n; --i > 0; ) {          /* shuffle the line indices */
+    s ^= s << 13; s ^= s >> 7; s ^= s << 17;   /* (xorshift64) */
+    k = (size_t)(s % (i+1)); x = idx[i]; idx[i] = idx[k]; idx[k] = x;
+  }                                 /* link the lines in this order */
+  for (i = 0; i < n; i++)           /* (a single cycle through all */
+    *(void**)(buf +idx[i] *line) = buf +idx[(i+1) % n] *line;
+  free(idx);                        /* lines, so that the prefetchers */
+  return (void**)buf;               /* cannot predict the accesses) */
+}  /* chain() */
+
+/*--------------------------------------------------------------------------*/
+
+static void** chase (void **p, long steps)
+{                                   /* --- follow a pointer chain */
+  long i;                           /* loop variable */
+  for (i = 0; i < steps; i += 4) {  /* every load depends on the */
+    p = (void**)*p; p = (void**)*p; /* previous one, so the time */
+    p = (void**)*p; p = (void**)*p; /* per step is the latency */
+  }
+  return p;                         /* return the final position */
+}  /* chase() */
+
+/*--------------------------------------------------------------------------*/
+
+static void pass (uint64_t *a, size_t n, int mode, int val)
+{                                   /* --- read or write an array once */
+  uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;  /* partial sums */
+  size_t   i;                       /* loop variable */
+
+  if (mode == MEM_WRITE) {          /* write the array */
+    memset(a, val, n *sizeof(uint64_t));
+    memsink = a[n-1]; return;       /* (use the result, so that */
+  }                                 /* the stores are not dropped) */
+  for (i = 0; i+4 <= n; i += 4) {   /* read the array with */
+    s0 += a[i];   s1 += a[i+1];     /* independent partial sums */
+    s2 += a[i+2]; s3 += a[i+3];
+  }
+  memsink = s0 +s1 +s2 +s3;         /* use the result */
+}  /* pass() */
+
+/*--------------------------------------------------------------------------*/
+
+static void* memjob (void *arg)
+{                                   /* --- run a memory probe job */
+  MEMJOB   *j = (MEMJOB*)arg;       /* memory probe job */
+  char     *buf;                    /* buffer of the working set */
+  void     **p = NULL;              /* start of the pointer chain */
+  size_t   n;                       /* number of array elements */
+  long     k, r = 0, reps;          /* ready threads, loop var., reps. */
+
+  if (j->set) cpuinfo_pin(j->set);  /* run on the given cpus */
+  buf = (j->node >= 0) ? cpuinfo_nodealloc(j->size, j->node)
+                       : cpuinfo_alloc(j->size, 4096);
+  n   = j->size /sizeof(uint64_t);  /* allocate the working set */
+  if (buf && (j->mode == MEM_LAT)) {/* build the pointer chain */
+    p = chain(buf, j->size, j->line);   /* (which also loads it */
+    if (p) p = chase(p, 4096); }    /* into the caches) and warm up */
+  else if (buf)                     /* touch the array (after pinning, */
+    pass((uint64_t*)buf, n, MEM_WRITE, 1);    /* so that it is local) */
+  reps = (long)(MEMBYTES /(int64_t)j->size);
+  if (reps < 1) reps = 1;           /* get the number of passes */
+  do { k = ATOMIC_LOAD(j->ready); } /* signal that this job is ready */
+  while (!ATOMIC_CAS(j->ready, k, k+1));
+  while (!ATOMIC_LOAD(j->go)) SPIN_PAUSE();
+  j->beg = cpuinfo_ticks();         /* wait for the common start */
+  if (p) {                          /* measure the latency */
+    for (r = 0; r < j->steps; ) {   /* (in chunks, so that slow */
+      p = chase(p, 4096); r += 4096;/* levels can stop early) */
+      if (cpuinfo_ticks_to_ns(cpuinfo_ticks() -j->beg) >= MEMTIME) break;
+    }
+    memsink = (uint64_t)(size_t)p; }
+  else if (buf)                     /* or the bandwidth */
+    for (r = 0; r < reps; r++) pass((uint64_t*)buf, n, j->mode, (int)r);
+  j->end   = cpuinfo_ticks();       /* note the end of the run */
+  j->bytes = (buf && !p) ? (double)reps *(double)(n *sizeof(uint64_t)) : 0;
+  j->lat   = (p && (r > 0))         /* (no steps: no latency) */
+           ? cpuinfo_ticks_to_ns(j->end -j->beg) /(double)r : -1;
+  if (j->node >= 0) cpuinfo_nodefree(buf, j->size);
+  else              cpuinfo_free(buf);
+  return NULL;                      /* delete the working set */
+}  /* memjob() */
+
+/*--------------------------------------------------------------------------*/
+
+#ifdef _WIN32                       /* if Microsoft Windows system */
+
+static DWORD WINAPI winjob (LPVOID arg)
+{                                   /* --- thread function for a job */
+  memjob(arg); return 0;            /* (adapts the signature of */
+}  /* winjob() */                   /* memjob() for CreateThread()) */
+
+/*--------------------------------------------------------------------------*/
+#endif
+
+static double runjobs (MEMJOB *jobs, int n)
+{                                   /* --- run memory probe jobs */
+  long     ready = 0, go = 0;       /* counter of ready jobs, start flag */
+  int      i;                       /* loop variable */
+  uint64_t beg, end;                /* start and end of all runs */
+  double   bytes = 0;               /* number of transferred bytes */
+  #ifdef _WIN32                     /* if Microsoft Windows system */
+  HANDLE    *th;                    /* threads running the jobs */
+  #else                             /* if POSIX threads are available */
+  pthread_t *th;                    /* threads running the jobs */
+  #endif
+
+  th = malloc((size_t)n *sizeof(*th));
+  if (!th) return -1;               /* start the jobs in threads */
+  for (i = 0; i < n; i++) {         /* (so that pinning does not */
+    jobs[i].ready = &ready;         /* affect the calling thread) */
+    jobs[i].go    = &go;
+    #ifdef _WIN32                   /* if Microsoft Windows system */
+    th[i] = CreateThread(NULL, 0, winjob, jobs +i, 0, NULL);
+    if (!th[i]) break;
+    #else                           /* if POSIX threads are available */
+    if (pthread_create(th +i, NULL, memjob, jobs +i) != 0) break;
+    #endif
+  }
+  n = i;                            /* wait until all jobs are ready */
+  #ifdef _WIN32                     /* if Microsoft Windows system */
+  while (ATOMIC_LOAD(&ready) < n) SwitchToThread();
+  ATOMIC_STORE(&go, 1);             /* start all jobs at once */
+  for (i = 0; i < n; i++) {         /* wait for the jobs to finish */
+    WaitForSingleObject(th[i], INFINITE); CloseHandle(th[i]); }
+  #else                             /* if POSIX threads are available */
+  while (ATOMIC_LOAD(&ready) < n) sched_yield();
+  ATOMIC_STORE(&go, 1);             /* start all jobs at once */
+  for (i = 0; i < n; i++) pthread_join(th[i], NULL);
+  #endif                            /* wait for the jobs to finish */
+  free(th);                         /* delete the thread handles */
+  if (n <= 0) return -1;            /* check for a started job */
+  beg = jobs[0].beg; end = jobs[0].end;
+  for (i = 0; i < n; i++) {         /* find the span of all runs */
+    if (jobs[i].beg < beg) beg = jobs[i].beg;
+    if (jobs[i].end > end) end = jobs[i].end;
+    bytes += jobs[i].bytes;         /* sum the transferred bytes */
+  }
+  if (jobs[0].mode == MEM_LAT) return jobs[0].lat;
+  return bytes /cpuinfo_ticks_to_ns(end -beg);
+}  /* runjobs() */                  /* return latency or GB/s */
+
+/*--------------------------------------------------------------------------*/
+
+static double latency (int64_t size, size_t line, long steps,
+                       const CPUSET *set, int node)
+{                                   /* --- measure the load latency */
+  MEMJOB j;                         /* memory probe job */
+  memset(&j, 0, sizeof(j));         /* set up the job */
+  j.set  = set;  j.mode  = MEM_LAT; j.node = node;
+  j.size = (size_t)size; j.line = line; j.steps = steps;
+  return runjobs(&j, 1);            /* run the job */
+}  /* latency() */
+
+/*--------------------------------------------------------------------------*/
+
+static double bandwidth (int64_t size, int mode, int n,
+                         const CPUSET *sets, int node)
+{                                   /* --- measure the bandwidth */
+  MEMJOB *j;                        /* memory probe jobs */
+  int    i;                         /* loop variable */
+  double r;                         /* bandwidth in GB/s */
+
+  j = calloc((size_t)n, sizeof(MEMJOB));
+  if (!j) return -1;                /* allocate the jobs */
+  for (i = 0; i < n; i++) {         /* set up a job per thread */
+    j[i].set  = (sets) ? sets +i : NULL; j[i].mode = mode;
+    j[i].node = node; j[i].size = (size_t)size;
+  }
+  r = runjobs(j, n);                /* run the jobs */
+  free(j);                          /* delete the jobs */
+  return r;                         /* return the bandwidth */
+}  /* bandwidth() */
+
+/*--------------------------------------------------------------------------*/
+
+static void initmem (void)
+{                                   /* --- measure the memory hierarchy */
+  const CPUCACHE *c;                /* description of a cache */
+  const CPUNUMA  *m = NULL;         /* NUMA node topology */
+  CPUMEMLVL      *v;                /* to traverse the levels */
+  CPUSET         *sets = NULL;      /* cpu sets of the threads */
+  CPUSET         set;               /* cpus of a node */
+  int            i, k, l, n, nn;    /* loop variables, # threads/nodes */
+  int            local;             /* whether the machine is local */
+  size_t         line;              /* cache line size */
+  int64_t        size, prev = 0;    /* working set size, prev. level */
+  double         t;                 /* latency threshold */
+
+  nn = (cpuinfo_numa(&m) == 0) ? m->nnodes : 1;
+  mem = calloc(1, sizeof(CPUMEM) +2*(size_t)(nn*nn) *sizeof(double));
+  if (!mem) return;                 /* allocate the result */
+  mem->nnodes  = nn;                /* and organize the memory */
+  mem->nodelat = (double*)(mem+1);
+  mem->nodebw  = mem->nodelat +nn*nn;
+  for (i = 0; i < 2*nn*nn; i++) mem->nodelat[i] = -1;
+  line = (cacheline() > 0) ? (size_t)cacheline() : 64;
+  for (l = 1; (l <= 4) && (mem->nlevels < CPUMEM_MAXLVL-1); l++) {
+    c = cpuinfo_cache(l, CPUCACHE_DATA);
+    if (!c || (c->size <= 0)) continue;
+    v = mem->levels +mem->nlevels++;
+    v->level = l;                   /* exceed the previous level */
+    v->size  = (prev > 0) ? 2*prev : c->size/2;
+    if (v->size > c->size/2) v->size = (prev +c->size)/2;
+    if (v->size > MEMMAX/4)  v->size = MEMMAX/4;
+    v->capacity = prev = c->size;   /* (capacity refined below) */
+  }
+  v = mem->levels +mem->nlevels++;  /* and exceed the last level */
+  v->level    = 0;                  /* for main memory */
+  v->size     = (4*prev < MEMMIN) ? MEMMIN
+              : (4*prev > MEMMAX) ? MEMMAX : 4*prev;
+  v->capacity = -1;
+  #ifdef __linux__                  /* measure all cores and the nodes */
+  local = !*getroot() && !fromfile();   /* only for the machine */
+  #else                             /* that this program runs on */
+  local = !fromfile();
+  #endif
+  n = (local) ? corecnt_effective() : 0;
+  if (n > 0) {                      /* place one thread per core */
+    sets = malloc((size_t)n *sizeof(CPUSET));
+    if (sets && (cpuinfo_place(n, CPU_PLACE_NOSMT, sets) <= 0)) {
+      free(sets); sets = NULL; }    /* (unpinned if placement fails) */
+  }
+  mem->nthreads = (n > 0) ? n : 0;
+
+  for (i = 0; i < mem->nlevels; i++) {
+    v = mem->levels +i;             /* traverse the levels */
+    v->latency = latency(v->size, line, MEMSTEPS, NULL, -1);
+    v->read    = bandwidth(v->size, MEM_READ,  1, NULL, -1);
+    v->write   = bandwidth(v->size, MEM_WRITE, 1, NULL, -1);
+    v->readall = v->writeall = -1;  /* measure one thread */
+    if (n <= 0) continue;           /* and then all cores */
+    if (n == 1) { v->readall = v->read; v->writeall = v->write; continue; }
+    c = (v->level > 0) ? cpuinfo_cache(v->level, CPUCACHE_DATA) : NULL;
+    k = (c && (c->ninst > 0)) ? (n +c->ninst-1) /c->ninst : 1;
+    size = (c) ? c->size/2 /k : v->size/n;
+    if (c && (size > v->size)) size = v->size;
+    if (!c && (size < MEMTHRMIN)) size = MEMTHRMIN;
+    if (size < (int64_t)(line *64)) size = (int64_t)(line *64);
+    v->readall  = bandwidth(size, MEM_READ,  n, sets, -1);
+    v->writeall = bandwidth(size, MEM_WRITE, n, sets, -1);
+  }                                 /* (share of a shared cache) */
+
+  v = mem->levels +mem->nlevels-1;  /* get the memory level */
+  for (k = 0, size = 4096; (size <= v->size) && (k < 2)
+  &&   (mem->nsweep < CPUMEM_MAXPTS); size *= 2) {
+    t = latency(size, line, MEMSTEPS/4, NULL, -1);
+    mem->sweepsize[mem->nsweep]  = size;
+    mem->sweeplat[mem->nsweep++] = t;
+    k = (t >= 0.8 *v->latency) ? k+1 : 0;
+  }                                 /* sweep the working set size */
+  for (i = 0; i < mem->nlevels-1; i++) {
+    v = mem->levels +i;             /* find the effective capacities */
+    t = 0.5 *(v->latency +v[1].latency);
+    if (v[1].latency <= v->latency) continue;
+    for (k = 0; k < mem->nsweep; k++)
+      if (mem->sweeplat[k] >= t) break;
+    if (k > 0) v->capacity = mem->sweepsize[k-1];
+  }                                 /* (largest size below threshold) */
+
+  v = mem->levels +mem->nlevels-1;  /* scale the memory bandwidth */
+  for (k = 1; (n > 0) && (mem->nscale < CPUMEM_MAXPTS); k *= 2) {
+    if (k > n) k = n;               /* 1, 2, 4, ... threads, all cores */
+    size = (v->size/k < MEMTHRMIN) ? MEMTHRMIN : v->size/k;
+    mem->scalethr[mem->nscale]  = k;/* (reuse one thread, all cores) */
+    mem->scalebw[mem->nscale++] = (k == 1) ? v->read : (k == n)
+                                ? v->readall
+                                : bandwidth(size, MEM_READ, k, sets, -1);
+    if (k >= n) break;
+  }
+
+  if (local && (nn <= 1)) {         /* for a single node */
+    mem->nodelat[0] = v->latency;   /* use the memory level */
+    mem->nodebw[0]  = v->read; }
+  else if (local && m) {            /* for several nodes */
+    for (i = 0; i < nn; i++) {      /* traverse the nodes with cpus */
+      if (m->nodeoff[i+1] <= m->nodeoff[i]) continue;
+      memset(&set, 0, sizeof(set)); /* collect the cpus of the node */
+      for (k = m->nodeoff[i]; k < m->nodeoff[i+1]; k++)
+        if (m->nodecpus[k] < CPUSET_MAX) CPUSET_SET(&set, m->nodecpus[k]);
+      if (cpuset_count(&set) <= 0)  /* skip nodes whose cpus are all */
+        continue;                   /* beyond CPUSET_MAX */
+      for (k = 0; k < nn; k++) {    /* traverse the memory nodes */
+        mem->nodelat[i*nn+k] = latency(v->size, line, MEMSTEPS/4, &set, k);
+        mem->nodebw [i*nn+k] = bandwidth(v->size, MEM_READ, 1, &set, k);
+      }                             /* measure from the cpus of node i */
+    }                               /* to the memory of node k */
+  }
+  free(sets);                       /* delete the cpu sets */
+}  /* initmem() */
+
+/*--------------------------------------------------------------------------*/
+
+const CPUMEM* cpuinfo_memory (void)
+{                                   /* --- get the memory hierarchy */
+  if (ATOMIC_LOAD(&memst) != 2) waitonce(&memst, initmem);
+  return mem;                       /* return the measurements */
+}  /* cpuinfo_memory() */
+
+/*--------------------------------------------------------------------------*/
+
+int64_t cpuinfo_memcap (int level)
+{                                   /* --- effective capacity of a level */
+  const CPUMEM *m = cpuinfo_memory();
+  int          i;                   /* loop variable */
+  for (i = 0; m && (i < m->nlevels); i++)
+    if (m->levels[i].level == level) return m->levels[i].capacity;
+  return -1;                        /* find the level */
+}  /* cpuinfo_memcap() */
+
+/*----------------------------------------------------------------------------
+Additional info and references (cpuinfo_memory):
+  The sizes reported by cpuid do not tell what a level costs or how much
+  of it a program actually gets, e.g. in VMs whose host partitions the
+  last level cache. cpuinfo_memory() therefore measures each data cache
+  level and main memory once (which takes about one or two seconds) and
+  keeps the results until the loaded data is discarded (cpuinfo_setroot(),
+  cpuinfo_import(), or cpuinfo_refresh() after a change). Other threads
+  that call it meanwhile sleep on a condition variable instead of
+  spinning, so that they do not take cpu time from the measurements
+  (the other data is loaded with a spin wait, as it takes at most a few
+  milliseconds). The working set of a cache level is twice the size of
+  the previous level (but at most half its own size and 64MB), so that
+  it is served by this level, that of main memory four times the last
+  level (64MB..256MB). The latency is
+  measured with a chain of pointers through the lines of the working set
+  in random order, so that each load depends on the previous one and
+  neither the hardware prefetchers nor the out-of-order core can hide it
+  (for at most 20ms per test); at large sizes it includes TLB misses, as
+  the memory is not allocated with huge pages.
+  The bandwidths are those of summing (read, with the baseline vector
+  instructions the module is compiled for, so the read bandwidth of the
+  first levels is a lower bound) and of memset() (write) on the working
+  set, by one thread and by one thread per core (placed with
+  CPU_PLACE_NOSMT), where the threads of a shared cache split its size.
+  The latencies of a sweep of working set sizes (4KB, 8KB, ...) yield the
+  effective capacity of each level (cpuinfo_memcap()): the largest size
+  whose latency stays below the mean of the latencies of the level and
+  of the next one (the sweep stops once two sizes reach 80% of the
+  memory latency). The memory read bandwidth is also measured with 1, 2,
+  4, ... threads up to one per core, which shows where it saturates. With
+  several NUMA nodes, the latency and the read bandwidth are measured
+  from the cpus of each node to the memory of each node (placed with
+  cpuinfo_nodealloc()), stored in nodelat/nodebw[i*nnodes+k]. With a
+  fake root or an imported description only the single thread tests are
+  run (on the sizes of the described caches). The test threads are
+  started with pthread_create() or CreateThread(); as cpuinfo_pin() is
+  only implemented on Linux, they are left to the scheduler elsewhere,
+  so that the multi-thread and per-node numbers are less reliable there
+  ("cpuinfo -m" marks them as not pinned). The numbers are meant for
+  choosing block sizes and thread counts; they vary somewhat between
+  runs, in particular on busy or virtualized machines. "cpuinfo -m"
+  prints them.
+  McCalpin, STREAM benchmark; lmbench lat_mem_rd; Drepper, "What Every
+  Programmer Should Know About Memory", sect. 3.3
+----------------------------------------------------------------------------*/
+#ifdef CPUINFO_MAIN
+
+int main (int argc, char* argv[])
+{
+  char vendor[12];
+  const CPUTOPO  *t;
+  const CPUCACHE *c;
+  const CPUTIMER *tm;
+  const CPUCUR   *cur;
+  const CPUMEM   *mm;
+  const CPUMEMLVL *v;
+  char buf[16];
+  uint32_t miss[CPU_FEATWORDS];
+  int i, n;
+  getVendorID(vendor);
+  printf("Vendor              %.12s\n", vendor);
+  printf("Physical processors %d\n", physcnt());
+  printf("Processor cores     %d\n", corecnt());
+  printf("Logical processors  %d\n", proccnt());
+  printf("Count backend       %s\n",
+         cpuinfo_backendname(cpuinfo_backend()));
   printf("MMX                 %d\n", hasMMX());
   printf("SSE                 %d\n", hasSSE());
   printf("SSE2                %d\n", hasSSE2());
@@ -532,6 +4465,135 @@ int main (int argc, char* argv[])
   printf("AVX512bw            %d\n", hasAVX512bw());
   printf("AVX512dq            %d\n", hasAVX512dq());
   printf("AVX512vl            %d\n", hasAVX512vl());
+  printf("BMI1                %d\n", hasBMI1());
+  printf("BMI2                %d\n", hasBMI2());
+  printf("LZCNT               %d\n", hasLZCNT());
+  printf("F16C                %d\n", hasF16C());
+  printf("ADX                 %d\n", hasADX());
+  printf("SHA                 %d\n", hasSHA());
+  printf("AES                 %d\n", hasAES());
+  printf("VAES                %d\n", hasVAES());
+  printf("VPCLMULQDQ          %d\n", hasVPCLMULQDQ());
+  printf("GFNI                %d\n", hasGFNI());
+  printf("AVX512ifma          %d\n", hasAVX512ifma());
+  printf("AVX512vnni          %d\n", hasAVX512vnni());
+  printf("AVX512bf16          %d\n", hasAVX512bf16());
+  printf("AVX512fp16          %d\n", hasAVX512fp16());
+  printf("AVX512vbmi          %d\n", hasAVX512vbmi());
+  printf("AVX512vbmi2         %d\n", hasAVX512vbmi2());
+  printf("AVX512bitalg        %d\n", hasAVX512bitalg());
+  printf("AVX512vpopcntdq     %d\n", hasAVX512vpopcntdq());
+  printf("AVXvnni             %d\n", hasAVXvnni());
+  printf("AVX10               %d\n", hasAVX10());
+  printf("AMXtile             %d\n", hasAMXtile());
+  printf("AMXint8             %d\n", hasAMXint8());
+  printf("AMXbf16             %d\n", hasAMXbf16());
+  printf("MOVDIRI             %d\n", hasMOVDIRI());
+  printf("SERIALIZE           %d\n", hasSERIALIZE());
+  printf("FPU                 %d\n", hasFPU());
+  printf("CX8                 %d\n", hasCX8());
+  printf("CMOV                %d\n", hasCMOV());
+  printf("FXSR                %d\n", hasFXSR());
+  printf("SYSCALL             %d\n", hasSYSCALL());
+  printf("CX16                %d\n", hasCX16());
+  printf("LAHF                %d\n", hasLAHF());
+  printf("MOVBE               %d\n", hasMOVBE());
+  printf("OSXSAVE             %d\n", hasOSXSAVE());
+  printf("RDTSCP              %d\n", hasRDTSCP());
+  printf("RDPID               %d\n", hasRDPID());
+  printf("Effective procs     %d\n", proccnt_effective());
+  printf("Effective cores     %d\n", corecnt_effective());
+  printf("NUMA nodes          %d\n", nodecnt());
+  printf("L3 domains          %d\n", l3cnt());
+  n = cpuinfo_x86level(miss);
+  printf("x86-64 level        v%d", n);
+  for (i = 0; (n < CPU_X86_64_V4) && (i < CPU_FEATCNT); i++)
+    if ((miss[i >> 5] >> (i & 31)) & 1)
+      printf(" -%s", cpuinfo_featname(i));
+  printf("\n");                     /* (missing for the next level) */
+  printf("Invariant TSC       %d\n", cpuinfo_get()->tscinv);
+  printf("XCR0                0x%llx%s%s%s\n",
+         (unsigned long long)cpuinfo_get()->xcr0,
+         cpuinfo_xstate(CPU_XSTATE_YMM) ? " ymm" : "",
+         cpuinfo_xstate(CPU_XSTATE_ZMM) ? " zmm" : "",
+         cpuinfo_xstate(CPU_XSTATE_AMX) ? " amx" : "");
+  tm = cpuinfo_timer();
+  printf("Timer               %s via %s, %.6g MHz, %.1f ns overhead, "
+         "%.1f ns resolution\n", (tm->source == CPUTIMER_CLOCK) ? "clock"
+         : (tm->source == CPUTIMER_TSC) ? "tsc" : "tsc (calibrated)",
+         (tm->read == CPUTIMER_READ_RDTSCP) ? "rdtscp"
+         : (tm->read == CPUTIMER_READ_LFENCE) ? "lfence;rdtsc" : "clock",
+         tm->hz *1e-6, tm->overhead, tm->resolution);
+  cur = cpuinfo_current();          /* get the current cpu */
+  printf("Current cpu         %d (core %d, package %d, node %d, l3 %d)"
+         " via %s\n", cur->cpu, cur->core, cur->pkg, cur->node, cur->l3,
+         (cpuinfo_curmethod() == CPUCUR_RDPID)  ? "rdpid"
+       : (cpuinfo_curmethod() == CPUCUR_RDTSCP) ? "rdtscp"
+       : (cpuinfo_curmethod() == CPUCUR_GETCPU) ? "getcpu" : "-");
+  printf("Padding size        %d bytes\n", cpuinfo_padsize());
+  n = cpuinfo_caches(&c);
+  for (i = 0; i < n; i++)
+    printf("L%d%-17s %dK, %d-byte lines, %d-way, %s%d cpu(s) x %d\n",
+           c[i].level, (c[i].type == CPUCACHE_DATA)  ? "d"
+                     : (c[i].type == CPUCACHE_INSTR) ? "i" : "",
+           c[i].size >> 10, c[i].line, c[i].ways,
+           (c[i].inclusive > 0) ? "inclusive, " : "",
+           c[i].nshare, c[i].ninst);
+  if ((argc > 2) && (strcmp(argv[1], "-e") == 0)
+  &&  (cpuinfo_export(argv[2]) != 0))
+    fprintf(stderr, "cannot write %s\n", argv[2]);
+  if ((argc > 1) && (strcmp(argv[1], "-t") == 0)
+  &&  (cpuinfo_topology(&t) == 0)) {
+    printf("\nPackages            %d\n", t->npkgs);
+    printf("Dies                %d\n", t->ndies);
+    printf("Sources             %s%s%s%s\n",
+           (t->flags & CPUTOPO_CPUID) ? "cpuid " : "",
+           (t->flags & CPUTOPO_SYSFS) ? "sysfs " : "",
+           (t->flags & CPUTOPO_AGREE) ? "(agree) " : "",
+           (t->flags & CPUTOPO_FILE)  ? "(file)" : "");
+    if (t->flags & CPUTOPO_HYBRID)
+      printf("Hybrid              %d perf., %d eff. cores\n",
+             t->ntype[CPU_CORE_PERF], t->ntype[CPU_CORE_EFF]);
+    printf("\ncpu  apic  pkg  die  core  smt  type   cap   l3\n");
+    for (i = 0; i < t->ncpus; i++)
+      if (t->cpus[i].pkg >= 0)
+        printf("%3d %5d %4d %4d %5d %4d %5s %5d %4d\n", i, t->cpus[i].apic,
+               t->cpus[i].pkg, t->cpus[i].die, t->cpus[i].core,
+               t->cpus[i].smt, (t->cpus[i].type == CPU_CORE_PERF) ? "P"
+                             : (t->cpus[i].type == CPU_CORE_EFF)  ? "E"
+                             : "-", t->cpus[i].capacity, cpuinfo_cpul3(i));
+  }
+  if ((argc > 1) && (strcmp(argv[1], "-m") == 0)
+  &&  ((mm = cpuinfo_memory()) != NULL)) {
+    printf("\nlevel   wset  capacity  latency    read   write  "
+           "read*  write*\n");
+    for (i = 0; i < mm->nlevels; i++) {
+      v = mm->levels +i;
+      if (v->level > 0) sprintf(buf, "L%d", v->level);
+      else              strcpy(buf, "mem");
+      printf("%-4s %6lldK ", buf, (long long)(v->size >> 10));
+      if (v->capacity < 0) printf("%9s ", "-");
+      else printf("%8lldK ", (long long)(v->capacity >> 10));
+      printf("%5.1f ns %7.1f %7.1f %6.1f %7.1f\n", v->latency,
+             v->read, v->write, v->readall, v->writeall);
+    }
+    printf("(bandwidths in GB/s, * with %d threads", mm->nthreads);
+    #ifndef __linux__               /* cpuinfo_pin() is not available, */
+    printf(", not pinned");         /* so the scheduler places the */
+    #endif                          /* threads of the tests */
+    printf(")\n");
+    printf("\nmemory read scaling");
+    for (i = 0; i < mm->nscale; i++)
+      printf(" %d:%.1f", mm->scalethr[i], mm->scalebw[i]);
+    printf("\n");
+    for (i = 0; (mm->nnodes > 1) && (i < mm->nnodes); i++) {
+      printf("node %d ->", i);      /* print the node matrix */
+      for (n = 0; n < mm->nnodes; n++)
+        printf(" %.0f ns/%.1f", mm->nodelat[i*mm->nnodes+n],
+               mm->nodebw[i*mm->nnodes+n]);
+      printf("\n");
+    }
+  }
 
 /*
    physcnt    -> number of physical processors/packages/sockets
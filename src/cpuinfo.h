@@ -6,12 +6,331 @@
 #ifndef CPUINFO_H
 #define CPUINFO_H
 
+#include <stdint.h>
+#include <stddef.h>
+
+/*----------------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------------*/
+#define CPU_MMX           0         /* processor features */
+#define CPU_SSE           1         /* (bit indices in CPUINFO.feats) */
+#define CPU_SSE2          2
+#define CPU_SSE3          3
+#define CPU_SSSE3         4
+#define CPU_SSE41         5
+#define CPU_SSE42         6
+#define CPU_POPCNT        7
+#define CPU_AVX           8
+#define CPU_AVX2          9
+#define CPU_FMA3         10
+#define CPU_AVX512F      11
+#define CPU_AVX512CD     12
+#define CPU_AVX512BW     13
+#define CPU_AVX512DQ     14
+#define CPU_AVX512VL     15
+#define CPU_BMI1         16
+#define CPU_BMI2         17
+#define CPU_LZCNT        18
+#define CPU_F16C         19
+#define CPU_ADX          20
+#define CPU_SHA          21
+#define CPU_AES          22
+#define CPU_VAES         23
+#define CPU_VPCLMULQDQ   24
+#define CPU_GFNI         25
+#define CPU_AVX512IFMA   26
+#define CPU_AVX512VNNI   27
+#define CPU_AVX512BF16   28
+#define CPU_AVX512FP16   29
+#define CPU_AVX512VBMI   30
+#define CPU_AVX512VBMI2  31
+#define CPU_AVX512BITALG 32
+#define CPU_AVX512VPOPCNTDQ 33
+#define CPU_AVXVNNI      34
+#define CPU_AVX10        35
+#define CPU_AMXTILE      36
+#define CPU_AMXINT8      37
+#define CPU_AMXBF16      38
+#define CPU_MOVDIRI      39
+#define CPU_SERIALIZE    40
+#define CPU_FPU          41
+#define CPU_CX8          42
+#define CPU_CMOV         43
+#define CPU_FXSR         44
+#define CPU_SYSCALL      45
+#define CPU_CX16         46
+#define CPU_LAHF         47
+#define CPU_MOVBE        48
+#define CPU_OSXSAVE      49
+#define CPU_RDTSCP       50
+#define CPU_RDPID        51
+#define CPU_FEATCNT      52         /* number of processor features */
+#define CPU_FEATWORDS    ((CPU_FEATCNT +31) >> 5)
+
+#define CPU_X86_64_V1     1         /* x86-64 psABI microarchitecture */
+#define CPU_X86_64_V2     2         /* levels (0: not even baseline) */
+#define CPU_X86_64_V3     3
+#define CPU_X86_64_V4     4
+
+#define CPU_XSTATE_SSE    0x02      /* XCR0 bits of the register state */
+#define CPU_XSTATE_YMM    0x06      /* components the OS must enable */
+#define CPU_XSTATE_ZMM    0xe6      /* (XSAVE) for SSE, AVX, AVX-512 */
+#define CPU_XSTATE_AMX    0x60000   /* and AMX tiles */
+
+#define CPUTOPO_CPUID  0x01         /* ids were read with cpuid */
+#define CPUTOPO_SYSFS  0x02         /* ids were read from sysfs */
+#define CPUTOPO_AGREE  0x04         /* cpuid and sysfs ids agree */
+#define CPUTOPO_HYBRID 0x08         /* cores differ in type/capacity */
+#define CPUTOPO_FILE   0x10         /* ids were imported from a file */
+
+#define CPU_CORE_ANY      0         /* core type unknown (homogeneous) */
+#define CPU_CORE_PERF     1         /* performance core (Core, big) */
+#define CPU_CORE_EFF      2         /* efficiency core (Atom, LITTLE) */
+#define CPU_CORE_TYPES    3         /* number of core types */
+#define CPU_CAPACITY_MAX  1024      /* capacity of the fastest cpus */
+
+#define CPU_CHANGE_ONLINE  0x01     /* cpus went online/offline */
+#define CPU_CHANGE_ALLOWED 0x02     /* allowed cpus or quota changed */
+
+#define CPU_BACKEND_AUTO  0         /* first backend that works */
+#define CPU_BACKEND_SYSFS 1         /* sysfs sibling lists */
+#define CPU_BACKEND_PROC  2         /* /proc/cpuinfo */
+#define CPU_BACKEND_CPUID 3         /* x2APIC ids (topology map) */
+#define CPU_BACKEND_HWLOC 4         /* hwloc (needs HAVE_HWLOC) */
+#define CPU_BACKEND_FILE  5         /* imported description file */
+#define CPU_BACKEND_CNT   6         /* number of backends */
+
+#define CPUSET_MAX     1024         /* max. number of logical cpus */
+#define CPUSET_SET(s,c)   ((s)->bits[(c) >> 6] |=  (uint64_t)1 << ((c) & 63))
+#define CPUSET_CLR(s,c)   ((s)->bits[(c) >> 6] &= ~((uint64_t)1 << ((c) & 63)))
+#define CPUSET_ISSET(s,c) (((s)->bits[(c) >> 6] >> ((c) & 63)) & 1)
+
+#define CPU_PLACE_COMPACT 0         /* fill cores, SMT siblings adjacent */
+#define CPU_PLACE_SCATTER 1         /* spread over packages and cores */
+#define CPU_PLACE_NOSMT   2         /* whole cores, no shared siblings */
+#define CPU_PLACE_L3      3         /* one worker per L3 cache instance */
+#define CPU_PLACE_NUMA    4         /* one worker per NUMA node */
+
+#define CPUCACHE_DATA     1         /* data cache */
+#define CPUCACHE_INSTR    2         /* instruction cache */
+#define CPUCACHE_UNIFIED  3         /* unified cache */
+
+#define CPUTIMER_CLOCK    0         /* monotonic system clock */
+#define CPUTIMER_TSC      1         /* TSC, frequency from cpuid */
+#define CPUTIMER_TSCCAL   2         /* TSC, calibrated frequency */
+
+#define CPUTIMER_READ_CLOCK  0      /* read the system clock */
+#define CPUTIMER_READ_RDTSCP 1      /* read the TSC with rdtscp */
+#define CPUTIMER_READ_LFENCE 2      /* read the TSC with lfence; rdtsc */
+
+#define CPUCUR_NONE       0         /* current cpu is unknown */
+#define CPUCUR_RDPID      1         /* read TSC_AUX with RDPID */
+#define CPUCUR_RDTSCP     2         /* read TSC_AUX with RDTSCP */
+#define CPUCUR_GETCPU     3         /* ask the OS (sched_getcpu()) */
+
+#define CPUMEM_MAXLVL     5         /* max. number of memory levels */
+#define CPUMEM_MAXPTS    32         /* max. number of sweep points */
+
+/*----------------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------------*/
+typedef struct {                    /* --- processor feature snapshot --- */
+  char     vendor[16];              /* vendor id (NUL-terminated) */
+  int      maxleaf;                 /* max. standard cpuid leaf */
+  int      maxext;                  /* max. extended cpuid leaf */
+  int      family;                  /* processor family */
+  int      model;                   /* processor model */
+  int      stepping;                /* processor stepping */
+  int      lpmax;                   /* max. # log. procs. per package */
+  int      clsize;                  /* CLFLUSH line size [bytes] */
+  int      tscinv;                  /* invariant TSC (0x80000007 EDX[8]) */
+  uint32_t tscnum;                  /* TSC/crystal ratio numerator */
+  uint32_t tscden;                  /* TSC/crystal ratio denominator */
+  uint32_t crystal;                 /* crystal clock frequency [Hz] */
+  int      basemhz;                 /* base frequency [MHz] (leaf 0x16) */
+  int      avx10ver;                /* AVX10 version (0: no AVX10) */
+  uint64_t xcr0;                    /* OS-enabled state (XGETBV, 0: none) */
+  uint32_t present[CPU_FEATWORDS];  /* features reported by cpuid */
+  uint32_t feats[CPU_FEATWORDS];    /* usable features (bitmask) */
+} CPUINFO;                          /* (processor feature snapshot) */
+
+typedef struct {                    /* --- set of logical cpus --- */
+  uint64_t bits[CPUSET_MAX/64];     /* bit mask indexed by cpu number */
+} CPUSET;                           /* (set of logical cpus) */
+
+typedef struct {                    /* --- location of a logical cpu --- */
+  int      apic;                    /* x2APIC id (-1 if unknown) */
+  int      pkg;                     /* package index (-1 if offline) */
+  int      die;                     /* die     index (over all packages) */
+  int      core;                    /* core    index (over all packages) */
+  int      smt;                     /* index of the sibling in the core */
+  int      type;                    /* core type (CPU_CORE_*) */
+  int      capacity;                /* relative capacity (1..1024) */
+} CPULOC;                           /* (location of a logical cpu) */
+
+typedef struct {                    /* --- processor topology --- */
+  int      ncpus;                   /* # entries of cpus (max. id +1) */
+  int      nprocs;                  /* # online logical processors */
+  int      ncores;                  /* # processor cores */
+  int      ndies;                   /* # dies */
+  int      npkgs;                   /* # packages/sockets */
+  int      flags;                   /* sources of the ids (CPUTOPO_*) */
+  int      ntype[CPU_CORE_TYPES];   /* # processor cores per core type */
+  CPULOC   *cpus;                   /* locations, indexed by cpu number */
+  int      *coreoff;                /* offsets into corecpus per core */
+  int      *corecpus;               /* logical cpus grouped by core */
+} CPUTOPO;                          /* (processor topology) */
+
+typedef struct {                    /* --- cache description --- */
+  int      level;                   /* cache level (1, 2, 3, ...) */
+  int      type;                    /* cache type (CPUCACHE_*) */
+  int      size;                    /* size in bytes */
+  int      line;                    /* line size in bytes */
+  int      ways;                    /* associativity (0: fully assoc.) */
+  int      sets;                    /* number of sets */
+  int      inclusive;               /* whether inclusive (-1: unknown) */
+  int      index;                   /* index in sysfs (-1: unknown) */
+  int      nshare;                  /* max. # log. cpus per instance */
+  int      ninst;                   /* number of instances */
+  int      *inst;                   /* instance index per logical cpu */
+  int      *instoff;                /* offsets into instcpus per inst. */
+  int      *instcpus;               /* logical cpus grouped by instance */
+} CPUCACHE;                         /* (cache description) */
+
+typedef struct {                    /* --- NUMA node --- */
+  int      id;                      /* node number (-1: no NUMA support) */
+  int      ncpus;                   /* number of logical cpus */
+  int64_t  memtotal;                /* total memory in bytes */
+  int64_t  memfree;                 /* free  memory in bytes (at load) */
+} CPUNODE;                          /* (NUMA node) */
+
+typedef struct {                    /* --- NUMA node topology --- */
+  int      nnodes;                  /* number of (online) nodes */
+  CPUNODE  *nodes;                  /* node descriptions */
+  int      *dist;                   /* distance matrix (nnodes^2) */
+  int      ncpus;                   /* # entries of cpunode */
+  int      *cpunode;                /* node index per logical cpu */
+  int      *nodeoff;                /* offsets into nodecpus per node */
+  int      *nodecpus;               /* logical cpus grouped by node */
+} CPUNUMA;                          /* (NUMA node topology) */
+
+typedef struct {                    /* --- effective cpu resources --- */
+  int      nallowed;                /* # allowed logical cpus */
+  int      ncores;                  /* # cores with allowed cpus */
+  double   quota;                   /* cpu quota in cpus (-1: none) */
+  int      nprocs;                  /* effective # logical processors */
+  int      ncoreseff;               /* effective # processor cores */
+  CPUSET   allowed;                 /* allowed logical cpus */
+  CPUSET   cores;                   /* cores (indices) of allowed cpus */
+} CPUEFF;                           /* (effective cpu resources) */
+
+typedef struct {                    /* --- tick timer --- */
+  int      source;                  /* source of ticks (CPUTIMER_*) */
+  int      read;                    /* how the ticks are read */
+                                    /* (CPUTIMER_READ_*) */
+  double   hz;                      /* ticks per second */
+  double   nspt;                    /* nanoseconds per tick */
+  double   overhead;                /* cost of cpuinfo_ticks() [ns] */
+  double   resolution;              /* smallest measurable step [ns] */
+} CPUTIMER;                         /* (tick timer) */
+
+typedef struct {                    /* --- location of current cpu --- */
+  int      cpu;                     /* logical processor number */
+  int      core;                    /* core    index (as in CPULOC) */
+  int      pkg;                     /* package index (as in CPULOC) */
+  int      node;                    /* NUMA node index (-1: unknown) */
+  int      l3;                      /* L3 domain index (-1: unknown) */
+} CPUCUR;                           /* (location of the current cpu) */
+
+typedef struct {                    /* --- measured memory level --- */
+  int      level;                   /* cache level (0: main memory) */
+  int64_t  size;                    /* working set per thread [bytes] */
+  int64_t  capacity;                /* effective capacity (-1: none) */
+  double   latency;                 /* load-to-use latency [ns] */
+  double   read;                    /* read  bandwidth, 1 thread [GB/s] */
+  double   write;                   /* write bandwidth, 1 thread [GB/s] */
+  double   readall;                 /* read  bandwidth, all cores */
+  double   writeall;                /* write bandwidth, all cores */
+} CPUMEMLVL;                        /* (measured memory level) */
+
+typedef struct {                    /* --- measured memory hierarchy --- */
+  int       nlevels;                /* number of levels (last: memory) */
+  CPUMEMLVL levels[CPUMEM_MAXLVL];  /* measured levels */
+  int       nthreads;               /* # threads for all cores (0: none) */
+  int       nsweep;                 /* number of latency sweep points */
+  int64_t   sweepsize[CPUMEM_MAXPTS];   /* working set sizes [bytes] */
+  double    sweeplat [CPUMEM_MAXPTS];   /* latencies [ns] */
+  int       nscale;                 /* number of scaling points */
+  int       scalethr [CPUMEM_MAXPTS];   /* numbers of threads */
+  double    scalebw  [CPUMEM_MAXPTS];   /* memory read bandwidth [GB/s] */
+  int       nnodes;                 /* number of NUMA nodes */
+  double    *nodelat;               /* latency cpu node -> memory node */
+  double    *nodebw;                /* read bandwidth (nnodes^2, -1: n/a) */
+} CPUMEM;                           /* (measured memory hierarchy) */
+
+typedef void CPUHOOK (long gen, int changes, void *data);
+
 /*----------------------------------------------------------------------------
   Functions
 ----------------------------------------------------------------------------*/
+extern const CPUINFO*
+                  cpuinfo_get        (void);
+extern int        cpuinfo_has        (int feat);
+extern const char*cpuinfo_featname   (int feat);
+extern int        cpuinfo_featbyname (const char *name);
+extern int        cpuinfo_xstate     (uint64_t mask);
+extern int        cpuinfo_x86level   (uint32_t missing[CPU_FEATWORDS]);
+extern int        cpuinfo_topology   (const CPUTOPO **map);
+extern int        cpuinfo_caches     (const CPUCACHE **caches);
+extern const CPUCACHE*
+                  cpuinfo_cache      (int level, int type);
+extern int        cpuinfo_numa       (const CPUNUMA **map);
+extern int        cpuinfo_cpunode    (int cpu);
+extern int        cpuinfo_cpul3      (int cpu);
+extern int        cpuinfo_l3set      (int dom, CPUSET *set);
+extern int        cpuinfo_effective  (const CPUEFF **eff);
+extern int        cpuinfo_setroot    (const char *path);
+extern int        cpuinfo_setbackend (int backend);
+extern int        cpuinfo_backend    (void);
+extern const char*cpuinfo_backendname(int backend);
+extern int        cpuinfo_refresh    (void);
+extern long       cpuinfo_generation (void);
+extern void       cpuinfo_onchange   (CPUHOOK *hook, void *data);
+extern int        cpuinfo_export     (const char *path);
+extern int        cpuinfo_import     (const char *path);
+extern int        cpuset_count       (const CPUSET *set);
+extern int        cpuinfo_place      (int n, int policy, CPUSET *sets);
+extern int        cpuinfo_pin        (const CPUSET *set);
+extern int        cpuinfo_partition  (int total, int n,
+                                      const CPUSET *sets, int *cnts);
+extern const CPUTIMER*
+                  cpuinfo_timer      (void);
+extern uint64_t   cpuinfo_ticks      (void);
+extern double     cpuinfo_ticks_to_ns(uint64_t ticks);
+extern const CPUCUR*
+                  cpuinfo_current    (void);
+extern int        cpuinfo_curmethod  (void);
+extern int        cpuinfo_padsize    (void);
+extern void*      cpuinfo_alloc      (size_t size, size_t align);
+extern void       cpuinfo_free       (void *p);
+extern void*      cpuinfo_percpu     (size_t size, int *n, size_t *stride);
+extern void*      cpuinfo_nodealloc  (size_t size, int node);
+extern void       cpuinfo_nodefree   (void *p, size_t size);
+extern const CPUMEM*
+                  cpuinfo_memory     (void);
+extern int64_t    cpuinfo_memcap     (int level);
+
 extern int physcnt       (void); /* # physical processors */
 extern int corecnt       (void); /* # processor cores */
 extern int proccnt       (void); /* # logical processors */
+extern int proccntmax    (void); /* max. # log. procs. per package */
+extern int nodecnt       (void); /* # NUMA nodes */
+extern int l3cnt         (void); /* # L3 cache domains */
+extern int corecntHwloc  (void); /* # cores according to hwloc */
+extern int proccnt_effective (void); /* # usable logical processors */
+extern int corecnt_effective (void); /* # usable processor cores */
+extern int cachesize     (int level); /* size of data cache [bytes] */
+extern int cacheline     (void); /* line size of L1 data cache */
 
 extern int hasMMX        (void);
 extern int hasSSE        (void);
@@ -29,5 +348,41 @@ extern int hasAVX512cd   (void);
 extern int hasAVX512bw   (void);
 extern int hasAVX512dq   (void);
 extern int hasAVX512vl   (void);
+extern int hasBMI1       (void);
+extern int hasBMI2       (void);
+extern int hasLZCNT      (void);
+extern int hasF16C       (void);
+extern int hasADX        (void);
+extern int hasSHA        (void);
+extern int hasAES        (void);
+extern int hasVAES       (void);
+extern int hasVPCLMULQDQ (void);
+extern int hasGFNI       (void);
+extern int hasAVX512ifma (void);
+extern int hasAVX512vnni (void);
+extern int hasAVX512bf16 (void);
+extern int hasAVX512fp16 (void);
+extern int hasAVX512vbmi (void);
+extern int hasAVX512vbmi2 (void);
+extern int hasAVX512bitalg (void);
+extern int hasAVX512vpopcntdq (void);
+extern int hasAVXvnni    (void);
+extern int hasAVX10      (void);
+extern int hasAMXtile    (void);
+extern int hasAMXint8    (void);
+extern int hasAMXbf16    (void);
+extern int hasMOVDIRI    (void);
+extern int hasSERIALIZE  (void);
+extern int hasFPU        (void);
+extern int hasCX8        (void);
+extern int hasCMOV       (void);
+extern int hasFXSR       (void);
+extern int hasSYSCALL    (void);
+extern int hasCX16       (void);
+extern int hasLAHF       (void);
+extern int hasMOVBE      (void);
+extern int hasOSXSAVE    (void);
+extern int hasRDTSCP     (void);
+extern int hasRDPID      (void);
 
 #endif  /* #ifndef CPUINFO_H */
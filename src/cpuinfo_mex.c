@@ -0,0 +1,250 @@
+/*----------------------------------------------------------------------------
+  File    : cpuinfo_mex.c
+  Contents: MATLAB/Octave gateway for the processor information queries
+  Author  : Kristian Loewe, Christian Borgelt
+----------------------------------------------------------------------------*/
+#include <string.h>
+#include "mex.h"
+#include "cpuinfo.h"
+
+/*----------------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------------*/
+#define ERRID  "cpuinfo:invalidArgument"
+
+/*----------------------------------------------------------------------------
+  Global Variables
+----------------------------------------------------------------------------*/
+static mxArray *info = NULL;        /* persistent description struct */
+static long    gen   = -1;          /* generation of the description */
+
+static const char *fields[] = {     /* fields of the description */
+  "vendor", "family", "model", "stepping", "x86level",
+  "physcnt", "corecnt", "proccnt", "proccnt_effective",
+  "corecnt_effective", "nodecnt", "l3cnt", "quota",
+  "features", "topology", "caches", "generation" };
+
+static const char *topofields[] = { /* fields of the topology */
+  "cpu", "apic", "pkg", "die", "core", "smt", "type", "capacity",
+  "l3", "node" };
+
+static const char *cachefields[] = {/* fields of the cache descriptions */
+  "level", "type", "size", "line", "ways", "nshare", "ninst" };
+
+static const char *poolfields[] = { /* fields of the pool layout */
+  "workers", "policy", "places", "cpus" };
+
+static const char *policies[] = {   /* names of the placement policies */
+  "compact", "scatter", "nosmt", "l3", "numa" };
+
+/*----------------------------------------------------------------------------
+  Functions
+----------------------------------------------------------------------------*/
+
+static void cleanup (void)
+{                                   /* --- clean up on clearing the MEX */
+  if (info) mxDestroyArray(info);
+  info = NULL; gen = -1;            /* delete the persistent struct */
+}  /* cleanup() */
+
+/*--------------------------------------------------------------------------*/
+
+static mxArray* scalar (double val)
+{ return mxCreateDoubleScalar(val); }
+
+/*--------------------------------------------------------------------------*/
+
+static mxArray* features (void)
+{                                   /* --- create the feature struct */
+  const char *names[CPU_FEATCNT];   /* names of the features */
+  mxArray    *f;                    /* created struct */
+  int        i;                     /* loop variable */
+
+  for (i = 0; i < CPU_FEATCNT; i++) names[i] = cpuinfo_featname(i);
+  f = mxCreateStructMatrix(1, 1, CPU_FEATCNT, names);
+  for (i = 0; i < CPU_FEATCNT; i++) /* one logical per feature */
+    mxSetFieldByNumber(f, 0, i, mxCreateLogicalScalar(cpuinfo_has(i)));
+  return f;                         /* return the created struct */
+}  /* features() */
+
+/*--------------------------------------------------------------------------*/
+
+static mxArray* topology (void)
+{                                   /* --- create the topology struct */
+  const CPUTOPO *t;                 /* processor topology */
+  const CPULOC  *l;                 /* location of a logical cpu */
+  mxArray       *s;                 /* created struct */
+  double        *v[10];             /* columns of the topology table */
+  int           i, k, n;            /* loop variables, number of cpus */
+
+  s = mxCreateStructMatrix(1, 1, 10, topofields);
+  if (cpuinfo_topology(&t) != 0) return s;
+  for (k = 0; k < 10; k++) {        /* create one column per field */
+    mxSetFieldByNumber(s, 0, k,
+      mxCreateDoubleMatrix((mwSize)t->nprocs, 1, mxREAL));
+    v[k] = mxGetPr(mxGetFieldByNumber(s, 0, k));
+  }
+  for (n = i = 0; i < t->ncpus; i++) {
+    l = t->cpus +i;                 /* traverse the online cpus */
+    if (l->pkg < 0) continue;       /* and store their locations */
+    v[0][n] = i;       v[1][n] = l->apic; v[2][n] = l->pkg;
+    v[3][n] = l->die;  v[4][n] = l->core; v[5][n] = l->smt;
+    v[6][n] = l->type; v[7][n] = l->capacity;
+    v[8][n] = cpuinfo_cpul3(i);     v[9][n] = cpuinfo_cpunode(i);
+    n++;                            /* (all indices are 0-based, */
+  }                                 /* as used by the C functions) */
+  return s;                         /* return the created struct */
+}  /* topology() */
+
+/*--------------------------------------------------------------------------*/
+
+static mxArray* caches (void)
+{                                   /* --- create the cache struct array */
+  const CPUCACHE *c;                /* cache descriptions */
+  mxArray        *s;                /* created struct array */
+  int            i, n;              /* loop variable, number of caches */
+
+  n = cpuinfo_caches(&c);           /* get the cache descriptions */
+  if (n < 0) n = 0;
+  s = mxCreateStructMatrix((mwSize)n, 1, 7, cachefields);
+  for (i = 0; i < n; i++) {         /* traverse the caches */
+    mxSetFieldByNumber(s, (mwIndex)i, 0, scalar(c[i].level));
+    mxSetFieldByNumber(s, (mwIndex)i, 1, mxCreateString(
+        (c[i].type == CPUCACHE_DATA)  ? "data"
+      : (c[i].type == CPUCACHE_INSTR) ? "instruction" : "unified"));
+    mxSetFieldByNumber(s, (mwIndex)i, 2, scalar(c[i].size));
+    mxSetFieldByNumber(s, (mwIndex)i, 3, scalar(c[i].line));
+    mxSetFieldByNumber(s, (mwIndex)i, 4, scalar(c[i].ways));
+    mxSetFieldByNumber(s, (mwIndex)i, 5, scalar(c[i].nshare));
+    mxSetFieldByNumber(s, (mwIndex)i, 6, scalar(c[i].ninst));
+  }
+  return s;                         /* return the created struct array */
+}  /* caches() */
+
+/*--------------------------------------------------------------------------*/
+
+static mxArray* describe (void)
+{                                   /* --- create the description */
+  const CPUINFO *ci = cpuinfo_get();/* processor feature snapshot */
+  const CPUEFF  *e;                 /* effective cpu resources */
+  mxArray       *s;                 /* created struct */
+
+  s = mxCreateStructMatrix(1, 1, 17, fields);
+  mxSetFieldByNumber(s, 0,  0, mxCreateString(ci->vendor));
+  mxSetFieldByNumber(s, 0,  1, scalar(ci->family));
+  mxSetFieldByNumber(s, 0,  2, scalar(ci->model));
+  mxSetFieldByNumber(s, 0,  3, scalar(ci->stepping));
+  mxSetFieldByNumber(s, 0,  4, scalar(cpuinfo_x86level(NULL)));
+  mxSetFieldByNumber(s, 0,  5, scalar(physcnt()));
+  mxSetFieldByNumber(s, 0,  6, scalar(corecnt()));
+  mxSetFieldByNumber(s, 0,  7, scalar(proccnt()));
+  mxSetFieldByNumber(s, 0,  8, scalar(proccnt_effective()));
+  mxSetFieldByNumber(s, 0,  9, scalar(corecnt_effective()));
+  mxSetFieldByNumber(s, 0, 10, scalar(nodecnt()));
+  mxSetFieldByNumber(s, 0, 11, scalar(l3cnt()));
+  mxSetFieldByNumber(s, 0, 12,
+    scalar((cpuinfo_effective(&e) == 0) ? e->quota : -1));
+  mxSetFieldByNumber(s, 0, 13, features());
+  mxSetFieldByNumber(s, 0, 14, topology());
+  mxSetFieldByNumber(s, 0, 15, caches());
+  mxSetFieldByNumber(s, 0, 16, scalar((double)cpuinfo_generation()));
+  return s;                         /* return the created struct */
+}  /* describe() */
+
+/*--------------------------------------------------------------------------*/
+
+static mxArray* pool (int policy, int n)
+{                                   /* --- create a pool layout */
+  CPUSET  *sets;                    /* cpu sets of the workers */
+  mxArray *s, *c, *v;               /* created struct, cell, vector */
+  double  *p;                       /* to traverse the cpu numbers */
+  int     i, k, m;                  /* loop variables, number of places */
+
+  if (n <= 0) n = corecnt_effective();
+  if (n <= 0) n = 1;                /* get the recommended # workers */
+  sets = mxCalloc((size_t)n, sizeof(CPUSET));
+  m = cpuinfo_place(n, policy, sets);
+  if (m <= 0) { m = 0; memset(sets, 0, (size_t)n *sizeof(CPUSET)); }
+  s = mxCreateStructMatrix(1, 1, 4, poolfields);
+  mxSetFieldByNumber(s, 0, 0, scalar(n));
+  mxSetFieldByNumber(s, 0, 1, mxCreateString(policies[policy]));
+  mxSetFieldByNumber(s, 0, 2, scalar(m));
+  c = mxCreateCellMatrix(1, (mwSize)n);
+  for (i = 0; i < n; i++) {         /* traverse the workers */
+    v = mxCreateDoubleMatrix(1, (mwSize)cpuset_count(sets +i), mxREAL);
+    p = mxGetPr(v);                 /* collect the cpus of a worker */
+    for (k = 0; k < CPUSET_MAX; k++)
+      if (CPUSET_ISSET(sets +i, k)) *p++ = k;
+    mxSetCell(c, (mwIndex)i, v);    /* store the (0-based) cpu numbers */
+  }                                 /* in the cell array */
+  mxSetFieldByNumber(s, 0, 3, c);
+  mxFree(sets);                     /* delete the cpu sets */
+  return s;                         /* return the created struct */
+}  /* pool() */
+
+/*--------------------------------------------------------------------------*/
+
+void mexFunction (int nlhs, mxArray *plhs[],
+                  int nrhs, const mxArray *prhs[])
+{                                   /* --- gateway function */
+  char cmd[16], pol[16];            /* command and policy names */
+  int  i, n = 0;                    /* loop variable, # workers */
+
+  if (nrhs < 1) {                   /* if no command is given */
+    if (!info || (cpuinfo_generation() != gen)) {
+      cleanup();                    /* (re)create the description */
+      gen  = cpuinfo_generation();  /* if it does not exist yet */
+      info = describe();            /* or if cpus changed */
+      mexMakeArrayPersistent(info);
+      mexAtExit(cleanup);           /* keep the description */
+    }                               /* across calls */
+    plhs[0] = mxDuplicateArray(info);
+    return;                         /* return a copy of it */
+  }
+  if (!mxIsChar(prhs[0]) || (mxGetString(prhs[0], cmd, sizeof(cmd)) != 0))
+    mexErrMsgIdAndTxt(ERRID, "command must be a string");
+  if (strcmp(cmd, "refresh") == 0) {/* if to check for changed cpus */
+    plhs[0] = scalar(cpuinfo_refresh());
+    return;                         /* (the description is recreated */
+  }                                 /* on the next call if necessary) */
+  if (strcmp(cmd, "parpool") != 0)
+    mexErrMsgIdAndTxt(ERRID, "unknown command '%s'", cmd);
+  i = CPU_PLACE_NOSMT;              /* default: one worker per core */
+  if (nrhs > 1) {                   /* get the placement policy */
+    if (!mxIsChar(prhs[1])
+    ||  (mxGetString(prhs[1], pol, sizeof(pol)) != 0))
+      mexErrMsgIdAndTxt(ERRID, "policy must be a string");
+    for (i = 0; i < (int)(sizeof(policies)/sizeof(*policies)); i++)
+      if (strcmp(pol, policies[i]) == 0) break;
+    if (i >= (int)(sizeof(policies)/sizeof(*policies)))
+      mexErrMsgIdAndTxt(ERRID, "unknown policy '%s'", pol);
+  }
+  if (nrhs > 2) {                   /* get the number of workers */
+    if (!mxIsNumeric(prhs[2]) || (mxGetNumberOfElements(prhs[2]) != 1))
+      mexErrMsgIdAndTxt(ERRID, "number of workers must be a scalar");
+    n = (int)mxGetScalar(prhs[2]);
+  }
+  plhs[0] = pool(i, n);             /* create the pool layout */
+}  /* mexFunction() */
+
+/*----------------------------------------------------------------------------
+Usage (MATLAB/Octave):
+  s = cpuinfo
+    Returns a struct with all counts, the usable features (one logical
+    per feature), the topology (one column per field, one row per online
+    logical cpu) and the caches. The struct is created once and kept in
+    persistent MEX memory, so that repeated calls (e.g. in every parfor
+    iteration) only copy it. It is recreated if cpuinfo('refresh')
+    detected changed cpus.
+  c = cpuinfo('refresh')
+    Checks for cpus that went online/offline or a changed cpuset/quota
+    (see cpuinfo_refresh()) and returns the changes (0: none).
+  p = cpuinfo('parpool' [, policy [, n]])
+    Returns a recommended worker count (by default the effective number
+    of cores, i.e. with affinity mask, cpuset and quota respected) and
+    the cpus of each worker for the given placement policy ('compact',
+    'scatter', 'nosmt' (default), 'l3' or 'numa'), e.g. for
+      q = parpool(p.workers);
+  All cpu numbers and indices are 0-based, as they are used by the
+  operating system (e.g. for taskset or numactl).
+----------------------------------------------------------------------------*/
@@ -0,0 +1,119 @@
+/*----------------------------------------------------------------------------
+  File    : dotprod.c
+  Contents: dot product with runtime ISA dispatch (example for cpudisp)
+  Author  : Kristian Loewe, Christian Borgelt
+----------------------------------------------------------------------------*/
+#if defined __GNUC__ && (defined __x86_64__ || defined __i386__)
+#  include <immintrin.h>
+#  define TARGET(t)  __attribute__((target(t)))
+#else
+#  error "this example needs gcc/clang on x86 (function target attributes)"
+#endif
+
+#include "cpudisp.h"
+#include "dotprod.h"
+
+/*----------------------------------------------------------------------------
+  Functions
+----------------------------------------------------------------------------*/
+
+float dot_naive (const float *a, const float *b, int n)
+{                                   /* --- dot product (generic) */
+  int   i;                          /* loop variable */
+  float s = 0;                      /* sum of products */
+  for (i = 0; i < n; i++) s += a[i] *b[i];
+  return s;                         /* return the dot product */
+}  /* dot_naive() */
+
+/*--------------------------------------------------------------------------*/
+
+TARGET("sse2")
+float dot_sse2 (const float *a, const float *b, int n)
+{                                   /* --- dot product (SSE2) */
+  int    i;                         /* loop variable */
+  float  s[4];                      /* buffer for horizontal sum */
+  __m128 x = _mm_setzero_ps();      /* accumulator */
+  for (i = 0; i+4 <= n; i += 4)
+    x = _mm_add_ps(x, _mm_mul_ps(_mm_loadu_ps(a+i), _mm_loadu_ps(b+i)));
+  _mm_storeu_ps(s, x);              /* sum the accumulator elements */
+  s[0] += s[1] +s[2] +s[3];         /* and process the remainder */
+  for ( ; i < n; i++) s[0] += a[i] *b[i];
+  return s[0];                      /* return the dot product */
+}  /* dot_sse2() */
+
+/*--------------------------------------------------------------------------*/
+
+TARGET("avx2,fma")
+float dot_avx2 (const float *a, const float *b, int n)
+{                                   /* --- dot product (AVX2/FMA3) */
+  int    i;                         /* loop variable */
+  float  s;                         /* sum of products */
+  __m256 x = _mm256_setzero_ps();   /* accumulator */
+  __m128 y;                         /* for horizontal sum */
+  for (i = 0; i+8 <= n; i += 8)
+    x = _mm256_fmadd_ps(_mm256_loadu_ps(a+i), _mm256_loadu_ps(b+i), x);
+  y = _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+  y = _mm_add_ps(y, _mm_movehl_ps(y, y));
+  y = _mm_add_ss(y, _mm_shuffle_ps(y, y, 1));
+  s = _mm_cvtss_f32(y);             /* sum the accumulator elements */
+  for ( ; i < n; i++) s += a[i] *b[i];
+  return s;                         /* return the dot product */
+}  /* dot_avx2() */
+
+/*--------------------------------------------------------------------------*/
+
+TARGET("avx512f")
+float dot_avx512 (const float *a, const float *b, int n)
+{                                   /* --- dot product (AVX-512F) */
+  int       i;                      /* loop variable */
+  __m512    x;                      /* accumulator */
+  __mmask16 m;                      /* mask for the remainder */
+  x = _mm512_setzero_ps();
+  for (i = 0; i+16 <= n; i += 16)
+    x = _mm512_fmadd_ps(_mm512_loadu_ps(a+i), _mm512_loadu_ps(b+i), x);
+  if (i < n) {                      /* process the remainder */
+    m = (__mmask16)((1u << (n-i)) -1);
+    x = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, a+i),
+                        _mm512_maskz_loadu_ps(m, b+i), x);
+  }
+  return _mm512_reduce_add_ps(x);   /* return the dot product */
+}  /* dot_avx512() */
+
+/*--------------------------------------------------------------------------*/
+
+static const CPUIMPL impls[] = {    /* implementations (best first) */
+  { "avx512f",   CPUDISP_FN(dot_avx512) },
+  { "avx2,fma3", CPUDISP_FN(dot_avx2)   },
+  { "sse2",      CPUDISP_FN(dot_sse2)   },
+  { "",          CPUDISP_FN(dot_naive)  },
+};
+
+static float dot_init (const float *a, const float *b, int n);
+DOTFN *dot = dot_init;              /* initially points to resolver stub */
+
+static const CPUSLOT slots[] = {    /* dispatch table of this module */
+  { (CPUFN*)&dot, impls, CPUDISP_CNT(impls) },
+};
+
+/*--------------------------------------------------------------------------*/
+
+static float dot_init (const float *a, const float *b, int n)
+{                                   /* --- resolve on first call */
+  cpudisp_init(slots, CPUDISP_CNT(slots));
+  return dot(a, b, n);              /* resolve the table and call */
+}  /* dot_init() */
+
+/*--------------------------------------------------------------------------*/
+#if CPUDISP_HAVE_IFUNC
+
+CPUDISP_IFUNC(float, dot_ifunc, (const float *a, const float *b, int n),
+              impls);
+
+#else
+
+float dot_ifunc (const float *a, const float *b, int n)
+{                                   /* --- fallback without ifunc */
+  return dot(a, b, n);
+}  /* dot_ifunc() */
+
+#endif  /* #if CPUDISP_HAVE_IFUNC .. #else .. */
@@ -0,0 +1,25 @@
+/*----------------------------------------------------------------------------
+  File    : dotprod.h
+  Contents: dot product with runtime ISA dispatch (example for cpudisp)
+  Author  : Kristian Loewe, Christian Borgelt
+----------------------------------------------------------------------------*/
+#ifndef DOTPROD_H
+#define DOTPROD_H
+
+/*----------------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------------*/
+typedef float DOTFN (const float *a, const float *b, int n);
+
+/*----------------------------------------------------------------------------
+  Functions
+----------------------------------------------------------------------------*/
+extern DOTFN *dot;                  /* dispatched via function pointer */
+extern DOTFN  dot_ifunc;            /* dispatched via GNU ifunc */
+
+extern DOTFN  dot_naive;            /* ISA-specific implementations */
+extern DOTFN  dot_sse2;             /* (for direct calls) */
+extern DOTFN  dot_avx2;
+extern DOTFN  dot_avx512;
+
+#endif  /* #ifndef DOTPROD_H */